@@ -0,0 +1,254 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <sstream>
+#include <fstream>
+#include <algorithm>
+
+#include "sys.h"
+#include "batch.h"
+#include "parallel.h"
+
+// Headless driver - runs a .sys file without the GUI. Under mpirun the bodies are distributed over the ranks.
+//   headless <system.sys> <duration [s]> <time step [s]> [options]
+//   headless --at <time [s]> <keyframes> [--3d] [--state <out.sys>]
+//   headless --batch <directory> <duration [s]> <time step [s]> [options]
+static const char* usage =
+    "usage: headless <system.sys> <duration [s]> <time step [s]>\n"
+    "       headless --at <time [s]> <keyframes> [--3d] [--state <out.sys>]\n"
+    "       headless --batch <directory> <duration [s]> <time step [s]> [options]\n"
+    "  --3d                 read and integrate the system in 3 dimensions\n"
+    "  --no-record          keep statistics only, no time series or graphs\n"
+    "  --state <out.sys>    write the final state\n"
+    "  --cache <dir>        reuse and store runs in a result cache\n"
+    "  --cache-limit <MB>   size limit of the cache (default 1024)\n"
+    "  --memory <MB>        memory budget of the recorded series, the rest spills to disk (default no limit)\n"
+    "  --spill-dir <dir>    directory of the spilled series (default the temporary directory)\n"
+    "  --energy-tol <x>     stop when the relative energy drift exceeds x\n"
+    "  --momentum-tol <x>   stop when the relative angular momentum drift exceeds x\n"
+    "  --warn-drift         only warn when a drift tolerance is exceeded\n"
+    "  --softening <m>      Plummer softening length\n"
+    "  --regularize <m>     regularize pairs closer than this\n"
+    "  --parareal <slices>  integrate the time slices in parallel (0 for one per thread)\n"
+    "  --coarse <factor>    Parareal coarse step, in time steps (default 4)\n"
+    "  --tolerance <x>      Parareal convergence tolerance (default 1e-10)\n"
+    "  --reference          also run serially, to report the speedup and deviation\n"
+    "  --events <list>      detect events: any of apsides,conjunctions,crossings\n"
+    "  --centre <name>      body apsides and crossings are taken around\n"
+    "  --observer <name>    body conjunctions and transits are seen from\n"
+    "  --event-log <path>   event log (default Data/events.txt)\n"
+    "  --keyframes <steps>  store the full state every <steps> steps in Data/keyframes.bin\n"
+    "  --at <time>          rebuild the state of a run at this time from its keyframes\n"
+    "  --batch              run every .sys file of the directory together, one system per SIMD lane\n"
+    "  --stream <steps>     print the state every <steps> steps as it is computed, nothing is recorded\n";
+
+// Command line options
+struct options{
+    std::string system, state, cacheDir, spillDir;
+    double duration = 0, timeStep = 0;
+    bool threeD = false, record = true;
+    double cacheLimit = 1024;
+    double memory = 0;
+    double softening = 0, regularization = 0;
+    long keyframes = 0, stream = 0;
+    bool query = false, batched = false;
+    double at = 0;
+    stopCriteria criteria;
+    pararealOptions parareal;
+    eventOptions events;
+};
+
+template <std::size_t D>
+int run(const options& opt, resultCache* cache){
+    basicSys<D> system;
+    if (!system.load(opt.system)){
+        std::cerr << "Could not open " << opt.system << "\n";
+        return 1;
+    }
+    system.setRecording(opt.record);
+    system.setMemoryBudget(std::uintmax_t(opt.memory*1024*1024), opt.spillDir);
+    system.setCache(cache);
+    system.setStopCriteria(opt.criteria);
+    system.setSoftening(opt.softening);
+    system.setRegularizationRadius(opt.regularization);
+    system.setParareal(opt.parareal);
+    system.setEvents(opt.events);
+    system.setKeyframeInterval(opt.keyframes);
+    // up-front estimate of the recorded series
+    std::uintmax_t recordSize = system.recordSize(opt.duration, opt.timeStep);
+    if (recordSize > 0 && parallel::rank() == 0){
+        std::cout << "Recorded series: " << recordSize/1048576. << " MB";
+        if (opt.memory > 0 && recordSize > system.getMemoryBudget()) std::cout << ", over the budget of " << opt.memory << " MB - the rest spills to disk";
+        std::cout << "\n";
+    }
+    system.solve(opt.duration, opt.timeStep, [](int value, const std::string& status){ std::cout << "\r" << status << std::flush; if (value == 0) std::cout << "\n"; });
+    if (parallel::rank() != 0) return 0;
+    // output - rank 0 goes through the same writers as a GUI run
+    if (opt.record) system.saveData();
+    std::filesystem::create_directory("Data");
+    system.saveReport("Data/report.txt");
+    if (opt.keyframes > 0) system.saveKeyframes("Data/keyframes.bin");
+    if (opt.state != ""){
+        basicSys<D> state;
+        for (auto& b : system.getState()) state.linkBody(b);
+        state.save(opt.state);
+    }
+    return 0;
+}
+
+// Lazy run - states are printed as the integration reaches them, nothing is recorded
+template <std::size_t D>
+int stream(const options& opt){
+    basicSys<D> system;
+    if (!system.load(opt.system)){
+        std::cerr << "Could not open " << opt.system << "\n";
+        return 1;
+    }
+    system.setStopCriteria(opt.criteria);
+    system.setSoftening(opt.softening);
+    system.setRegularizationRadius(opt.regularization);
+    bool root = parallel::rank() == 0;
+    std::cout.precision(10);
+    if (root) std::cout << "# time [s] | body | position [m] | velocity [ms^-1]\n";
+    // every rank takes part in the integration, rank 0 prints
+    for (auto& state : system.run(opt.duration, opt.timeStep, opt.stream)){
+        if (!root) continue;
+        for (auto& b : state.bodies){
+            std::cout << state.time << " " << b.getName();
+            for (std::size_t k = 0; k < D; k++) std::cout << " " << b.getPosition()[k];
+            for (std::size_t k = 0; k < D; k++) std::cout << " " << b.getVelocity()[k];
+            std::cout << "\n";
+        }
+    }
+    if (root && system.getStopReason() != stopReason::none) std::cout << "# stopped at t = " << system.getStopTime() << " s: " << system.getStopMessage() << "\n";
+    return 0;
+}
+
+// State of a finished run at one time, from its keyframes
+template <std::size_t D>
+int query(const options& opt){
+    basicSys<D> run;
+    if (!run.loadKeyframes(opt.system)){
+        std::cerr << "Could not read keyframes from " << opt.system << "\n";
+        return 1;
+    }
+    std::vector<basicBody<D>> bodies = run.stateAt(opt.at);
+    if (bodies.empty()){
+        std::cerr << "t = " << opt.at << " s is outside the run, which lasted " << run.getDuration() << " s\n";
+        return 1;
+    }
+    basicSys<D> state;
+    for (auto& b : bodies) state.linkBody(b);
+    std::cout.precision(10);
+    std::cout << "|| State at t = " << opt.at << " s\n";
+    for (auto& b : state.getBodies()){
+        std::cout << b.getName() << " pos";
+        for (std::size_t k = 0; k < D; k++) std::cout << " " << b.getPosition()[k];
+        std::cout << " vel";
+        for (std::size_t k = 0; k < D; k++) std::cout << " " << b.getVelocity()[k];
+        std::cout << "\n";
+    }
+    if (opt.state != "") state.save(opt.state);
+    return 0;
+}
+
+// Ensemble of systems with the same number of bodies, stepped together - outcomes go to Data/batch.txt
+template <std::size_t D>
+int runBatch(const options& opt){
+    if (parallel::rank() != 0) return 0;
+    std::vector<std::filesystem::path> files;
+    std::error_code error;
+    for (auto& entry : std::filesystem::directory_iterator(opt.system, error)) if (entry.path().extension() == ".sys") files.push_back(entry.path());
+    std::sort(files.begin(), files.end());
+    batch<D> ensemble;
+    std::vector<std::string> names;
+    for (auto& file : files){
+        basicSys<D> system;
+        if (!system.load(file.string()) || system.size() == 0){ std::cerr << "Could not read " << file.string() << "\n"; continue; }
+        system.setStopCriteria(opt.criteria);
+        system.setSoftening(opt.softening);
+        if (ensemble.add(system)) names.push_back(file.filename().string());
+        else std::cerr << "Skipping " << file.string() << ", the batch has " << ensemble.bodyCount() << " bodies per system\n";
+    }
+    if (ensemble.size() == 0){
+        std::cerr << "No systems to run in " << opt.system << "\n";
+        return 1;
+    }
+    ensemble.solve(opt.duration, opt.timeStep, [](int value, const std::string& status){ std::cout << "\r" << status << std::flush; if (value == 0) std::cout << "\n"; });
+    std::filesystem::create_directory("Data");
+    std::ofstream out ("Data/batch.txt");
+    out << "# system | duration [s] | energy drift | angular momentum drift | outcome\n";
+    for (std::size_t k = 0; k < ensemble.size(); k++){
+        const basicSys<D>& s = ensemble[k];
+        out << names[k] << " " << (s.getStopReason() == stopReason::none ? opt.duration : s.getStopTime()) << " " << s.getEnergyDrift() << " " << s.getMomentumDrift()
+            << " " << (s.getStopReason() == stopReason::none ? "completed" : s.getStopMessage()) << "\n";
+    }
+    return 0;
+}
+
+int main(int argc, char** argv){
+    parallel::init(&argc, &argv);
+    std::vector<std::string> args (argv+1, argv+argc);
+    std::vector<std::string> positional;
+    options opt;
+    for (std::size_t i = 0; i < args.size(); i++){
+        bool value = i+1 < args.size();
+        if (args[i] == "--3d") opt.threeD = true;
+        else if (args[i] == "--no-record") opt.record = false;
+        else if (args[i] == "--state" && value) opt.state = args[++i];
+        else if (args[i] == "--cache" && value) opt.cacheDir = args[++i];
+        else if (args[i] == "--cache-limit" && value) opt.cacheLimit = std::stod(args[++i]);
+        else if (args[i] == "--memory" && value) opt.memory = std::stod(args[++i]);
+        else if (args[i] == "--spill-dir" && value) opt.spillDir = args[++i];
+        else if (args[i] == "--energy-tol" && value) opt.criteria.energyDrift = std::stod(args[++i]);
+        else if (args[i] == "--momentum-tol" && value) opt.criteria.momentumDrift = std::stod(args[++i]);
+        else if (args[i] == "--warn-drift") opt.criteria.warnOnDrift = true;
+        else if (args[i] == "--softening" && value) opt.softening = std::stod(args[++i]);
+        else if (args[i] == "--regularize" && value) opt.regularization = std::stod(args[++i]);
+        else if (args[i] == "--parareal" && value){ opt.parareal.enabled = true; opt.parareal.slices = std::stoi(args[++i]); }
+        else if (args[i] == "--coarse" && value) opt.parareal.coarseFactor = std::stoi(args[++i]);
+        else if (args[i] == "--tolerance" && value) opt.parareal.tolerance = std::stod(args[++i]);
+        else if (args[i] == "--reference") opt.parareal.reference = true;
+        else if (args[i] == "--events" && value){
+            std::stringstream list (args[++i]);
+            std::string item;
+            while (std::getline(list, item, ',')){
+                if (item == "apsides") opt.events.apsides = true;
+                else if (item == "conjunctions") opt.events.conjunctions = true;
+                else if (item == "crossings") opt.events.crossings = true;
+            }
+        }
+        else if (args[i] == "--centre" && value) opt.events.centre = args[++i];
+        else if (args[i] == "--observer" && value) opt.events.observer = args[++i];
+        else if (args[i] == "--event-log" && value) opt.events.path = args[++i];
+        else if (args[i] == "--keyframes" && value) opt.keyframes = std::stol(args[++i]);
+        else if (args[i] == "--at" && value){ opt.query = true; opt.at = std::stod(args[++i]); }
+        else if (args[i] == "--batch") opt.batched = true;
+        else if (args[i] == "--stream" && value) opt.stream = std::stol(args[++i]);
+        else positional.push_back(args[i]);
+    }
+    if (positional.size() != (opt.query ? 1 : 3)){
+        if (parallel::rank() == 0) std::cerr << usage;
+        parallel::finalize();
+        return 1;
+    }
+    opt.system = positional[0];
+    if (opt.query){
+        int status = parallel::rank() == 0 ? (opt.threeD ? query<3>(opt) : query<2>(opt)) : 0;
+        parallel::finalize();
+        return status;
+    }
+    opt.duration = std::stod(positional[1]);
+    opt.timeStep = std::stod(positional[2]);
+    if (opt.batched || opt.stream > 0){
+        int status = opt.batched ? (opt.threeD ? runBatch<3>(opt) : runBatch<2>(opt)) : (opt.threeD ? stream<3>(opt) : stream<2>(opt));
+        parallel::finalize();
+        return status;
+    }
+    resultCache cache (opt.cacheDir, std::uintmax_t(opt.cacheLimit*1024*1024));
+    resultCache* useCache = opt.cacheDir != "" ? &cache : nullptr;
+    int status = opt.threeD ? run<3>(opt, useCache) : run<2>(opt, useCache);
+    parallel::finalize();
+    return status;
+}
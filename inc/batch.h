@@ -0,0 +1,47 @@
+#ifndef __BATCH__
+#define __BATCH__
+
+#include <vector>
+#include <string>
+#include <atomic>
+
+#include "sys.h"
+
+// Batched integration - many independent systems with the same number of bodies, stepped together one system
+// per SIMD lane. Systems are taken in blocks of `width`; within a block every quantity of a body is stored for
+// all lanes side by side, so each operation of the force loop runs over the whole block at once. A system that
+// stops early keeps its lane, masked out of the updates, and a block ends when all of its systems have stopped.
+// Blocks are independent and run on all hardware threads.
+//
+// Lanes follow exactly the steps of basicSys::solve (same results, bit for bit) for the dynamics: stop criteria,
+// softening and the conservation monitor apply per system; temperatures, data extraction, regularization,
+// events and keyframes are not part of batched runs.
+template <std::size_t D>
+class batch{
+public:
+    using body = basicBody<D>;
+    static constexpr std::size_t width = 8;     // lanes per block
+
+private:
+    std::vector<basicSys<D>> systems;
+    std::size_t N = 0;
+    double softening = 0;
+    const std::atomic<bool>* cancelToken = nullptr;
+    void solveBlock(std::size_t b, double T, double dT);
+
+public:
+    batch() = default;
+    // Add a system with its own stop criteria - every system needs the same number of bodies and softening.
+    // Returns false (and leaves the batch unchanged) otherwise
+    bool add(const basicSys<D>& s);
+    std::size_t size() const {return systems.size();}
+    std::size_t bodyCount() const {return N;}
+    // Systems of the batch, holding the outcome of the last run (state, stop reason, conservation drifts)
+    const basicSys<D>& operator[](std::size_t k) const {return systems[k];}
+    // Every running system stops at its next step once the token is set
+    void setCancelToken(const std::atomic<bool>* token){cancelToken = token;}
+    void solve(double T, double dT, progressCallback progress = {});
+
+};
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef __BINARY__
+#define __BINARY__
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <type_traits>
+
+// Binary I/O helpers - raw native-endian serialization of trivially copyable values, strings and nested vectors
+namespace binary{
+
+    template <typename T> requires std::is_trivially_copyable_v<T>
+    void write(std::ostream& out, const T& value){
+        out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+    inline void write(std::ostream& out, const std::string& s){
+        write(out, std::uint64_t(s.size()));
+        out.write(s.data(), s.size());
+    }
+    template <typename T>
+    void write(std::ostream& out, const std::vector<T>& v){
+        write(out, std::uint64_t(v.size()));
+        if constexpr (std::is_trivially_copyable_v<T>) out.write(reinterpret_cast<const char*>(v.data()), v.size()*sizeof(T));
+        else for (auto& elem : v) write(out, elem);
+    }
+
+    template <typename T> requires std::is_trivially_copyable_v<T>
+    bool read(std::istream& in, T& value){
+        return bool(in.read(reinterpret_cast<char*>(&value), sizeof(T)));
+    }
+    inline bool read(std::istream& in, std::string& s){
+        std::uint64_t n;
+        if (!read(in, n)) return false;
+        s.resize(n);
+        return bool(in.read(s.data(), n));
+    }
+    template <typename T>
+    bool read(std::istream& in, std::vector<T>& v){
+        std::uint64_t n;
+        if (!read(in, n)) return false;
+        v.resize(n);
+        if constexpr (std::is_trivially_copyable_v<T>) return bool(in.read(reinterpret_cast<char*>(v.data()), n*sizeof(T)));
+        else for (auto& elem : v) if (!read(in, elem)) return false;
+        return true;
+    }
+
+    // FNV-1a hash of a byte string
+    inline std::uint64_t hash(const std::string& bytes){
+        std::uint64_t h = 14695981039346656037ull;
+        for (unsigned char c : bytes){ h ^= c; h *= 1099511628211ull; }
+        return h;
+    }
+
+}
+
+#endif
@@ -2,42 +2,73 @@
 #define __BODY__
 
 #include <cmath>
-#include "vec2.h"
+#include <string>
+#include "vec.h"
+#include "binary.h"
 
-// Celestial Body class - holds all the information needed to describe a celestial body
-class body{
+// Celestial Body class - holds all the information needed to describe a celestial body in D dimensions
+template <std::size_t D>
+class basicBody{
+
+public:
+    using vecD = vec<double,D>;
 
 private:
     // planet scalar and vector quantities
     std::string name;
     double mass, radius, temperature;
-    vec2 position, velocity, acceleration;
+    vecD position, velocity, acceleration;
     bool isHeatSource;
     // rotational quantities
     double angularVelocity, angle;
 
 public:
     // initialize
-    body() = default;
-    body(double M, double R, vec2 pos, vec2 vel, vec2 acc, double angulVel, std::string n, double T, bool heatSource, double dayAngle)
-    : mass(M), radius(R), position(pos), velocity(vel), acceleration(acc), name(n),
-     angle(dayAngle), angularVelocity(angulVel), temperature(T), isHeatSource(heatSource)
+    basicBody() = default;
+    basicBody(double M, double R, vecD pos, vecD vel, vecD acc, double angulVel, std::string n, double T, bool heatSource, double dayAngle)
+    : name(n), mass(M), radius(R), temperature(T), position(pos), velocity(vel), acceleration(acc),
+     isHeatSource(heatSource), angularVelocity(angulVel), angle(dayAngle)
     {}
     // inherent quantities
-    double getMass() { return mass; }
-    double getRadius() { return radius; }
-    double getTemperature() { return temperature; }
-    double getAngle () { return angle; }
+    double getMass() const { return mass; }
+    double getRadius() const { return radius; }
+    double getTemperature() const { return temperature; }
+    double getAngle () const { return angle; }
     double getAngularVelocity() const { return angularVelocity; }
-    vec2 getPosition () { return position; }
-    vec2 getVelocity () { return velocity; }
-    vec2 getAcceleration () { return acceleration; }
-    std::string getName () { return name; }
-    bool getIsHeatSource() {return isHeatSource; }
-    // useful quantities
-    vec2 getRotationPoint () { return position + radius*vec2(sin(angle),cos(angle));}
-    double getOriginAngle() { return atan2(position.Y(),position.X()); }
+    const vecD& getPosition () const { return position; }
+    const vecD& getVelocity () const { return velocity; }
+    const vecD& getAcceleration () const { return acceleration; }
+    const std::string& getName () const { return name; }
+    bool getIsHeatSource() const {return isHeatSource; }
+    // useful quantities - rotation happens in the x-y plane
+    vecD getRotationPoint () const { vecD r; r[0] = sin(angle); r[1] = cos(angle); return position + radius*r;}
+    double getOriginAngle() const { return atan2(position.Y(),position.X()); }
 
 };
 
+// Binary serialization
+template <std::size_t D>
+void writeBody(std::ostream& out, const basicBody<D>& b){
+    binary::write(out, b.getName());
+    binary::write(out, b.getMass()); binary::write(out, b.getRadius()); binary::write(out, b.getTemperature());
+    binary::write(out, b.getPosition()); binary::write(out, b.getVelocity()); binary::write(out, b.getAcceleration());
+    binary::write(out, b.getIsHeatSource()); binary::write(out, b.getAngularVelocity()); binary::write(out, b.getAngle());
+}
+
+template <std::size_t D>
+bool readBody(std::istream& in, basicBody<D>& b){
+    std::string name;
+    double M, R, T, angulVel, dayAngle;
+    vec<double,D> pos, vel, acc;
+    bool heatSource;
+    if (!(binary::read(in, name) && binary::read(in, M) && binary::read(in, R) && binary::read(in, T)
+      && binary::read(in, pos) && binary::read(in, vel) && binary::read(in, acc)
+      && binary::read(in, heatSource) && binary::read(in, angulVel) && binary::read(in, dayAngle))) return false;
+    b = basicBody<D>(M,R,pos,vel,acc,angulVel,name,T,heatSource,dayAngle);
+    return true;
+}
+
+// Planar bodies
+using body = basicBody<2>;
+
 #endif
@@ -0,0 +1,33 @@
+#ifndef __CACHE__
+#define __CACHE__
+
+#include <string>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <iostream>
+#include <filesystem>
+
+// Result cache - completed runs kept on disk, addressed by a hash of their initial state and solver parameters.
+// Files are touched on every hit; the least recently used ones are evicted once the size limit is exceeded.
+class resultCache{
+
+private:
+    std::filesystem::path directory;
+    std::uintmax_t maxBytes;
+    std::mutex lock;
+    std::filesystem::path path(std::uint64_t key) const;
+    void evict(const std::filesystem::path& keep);
+
+public:
+    resultCache(std::string dir = "Cache", std::uintmax_t limit = std::uintmax_t(1) << 30);
+    // read a cached run through `read`, false on a miss or an unreadable entry
+    bool load(std::uint64_t key, const std::function<bool(std::istream&)>& read);
+    // write a run through `write`, replacing any previous entry with this key
+    void store(std::uint64_t key, const std::function<void(std::ostream&)>& write);
+    void setLimit(std::uintmax_t limit);
+    std::uintmax_t getLimit() const { return maxBytes; }
+
+};
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef __EVENTS__
+#define __EVENTS__
+
+#include <string>
+#include <cstdint>
+
+// Orbital events
+enum class eventType : std::uint8_t { periapsis, apoapsis, conjunction, opposition, transit, crossing };
+constexpr int eventTypes = 6;
+
+// One event - a and b are body indices of the run; for a transit a is the body in front
+struct event{
+    double time;
+    eventType type;
+    int a, b;
+    double value;   // distance for apsides and crossings [m], apparent separation for the others [rad]
+};
+
+// Event detection - evaluated inside the integration loop on the two ends of every step, with the event
+// times refined by root finding on the cubic Hermite interpolant of the step. Events stream to a text log.
+// Event times share the axis of the recorded series, whose samples carry the time of the state they hold.
+struct eventOptions{
+    bool apsides = false;       // periapsis/apoapsis - sign change of the radial velocity
+    bool conjunctions = false;  // conjunctions, oppositions and transits seen by the observer - sign change of the in-plane alignment
+    bool crossings = false;     // two bodies swap their order in distance from the centre
+    std::string centre;         // apsides relative to this body only (every pair when empty), crossings around it
+    std::string observer;
+    std::string path = "Data/events.txt";
+    bool enabled() const { return apsides || conjunctions || crossings; }
+};
+
+std::string toString(eventType t);
+
+#endif
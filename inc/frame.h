@@ -14,16 +14,20 @@
 #include <fstream>
 #include <algorithm>
 #include <thread>
+#include <memory>
+#include <mutex>
 
-#include "vec2.h"
+#include "vec.h"
 #include "body.h"
 #include "sys.h"
 #include "utility.h"
+#include "scheduler.h"
 
 // Frame class
 class frame: public wxFrame{
 public:
     frame(const wxString& title, const wxPoint& pos, const wxSize& size);
+    ~frame();
     wxGauge* progress_bar;
 private:
     void OnHello(wxCommandEvent& event);
@@ -40,12 +44,25 @@ private:
     void Load(wxCommandEvent& event);
     void updateProgress(wxCommandEvent& event);
     void updateStatus(wxCommandEvent& event);
+    void updateJobs(wxCommandEvent& event);
+    void listJobs();
+    void CancelJob(wxCommandEvent& event);
+    void RaisePriority(wxCommandEvent& event);
+    void LowerPriority(wxCommandEvent& event);
+    void ClearJobs(wxCommandEvent& event);
+    void ChangeSlots(wxCommandEvent& event);
+    void EstimateMemory(wxCommandEvent& event);
+    void updateEstimate();
     wxDECLARE_EVENT_TABLE();
 private:
 
     wxPanel* panel;
 
     sys starSystem;
+    std::unique_ptr<scheduler> jobs;
+    resultCache cache;
+    std::vector<job::id> jobIds;
+    std::mutex outputLock;
     wxArrayString bodyNames;
 
     wxTextCtrl* albedo_value;
@@ -96,6 +113,36 @@ private:
 
     wxCheckBox* select_rotation;
 
+    wxCheckBox* select_record;
+
+    wxStaticText* escape_text;
+    wxTextCtrl* escape_value;
+    wxStaticText* hill_text;
+    wxTextCtrl* hill_value;
+    wxStaticText* drift_text;
+    wxTextCtrl* drift_value;
+    wxTextCtrl* momentum_drift_value;
+    wxCheckBox* select_drift_warn;
+    wxCheckBox* select_collisions;
+
+    wxStaticText* softening_text;
+    wxTextCtrl* softening_value;
+    wxStaticText* regularization_text;
+    wxTextCtrl* regularization_value;
+
+    wxStaticText* memory_text;
+    wxTextCtrl* memory_value;
+    wxStaticText* memory_estimate;
+
+    wxStaticText* jobs_text;
+    wxListBox* job_list;
+    wxButton* cancel_job_button;
+    wxButton* raise_priority_button;
+    wxButton* lower_priority_button;
+    wxButton* clear_jobs_button;
+    wxStaticText* slots_text;
+    wxChoice* slots_choice;
+
     wxArrayString timeUnits;
     wxArrayString lengthUnits;
     wxArrayString massUnits;
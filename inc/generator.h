@@ -0,0 +1,52 @@
+#ifndef __GENERATOR__
+#define __GENERATOR__
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+#include "body.h"
+#include "vec.h"
+
+// Procedural generation of large populations - debris rings, planetesimal disks and clusters.
+// Every body is drawn from its own random stream, so a seed gives the same population whatever the
+// number of threads or the order in which parts of it are generated.
+namespace generator{
+
+    // Distributions
+    //   disk    - annulus between innerRadius and outerRadius, surface density ~ r^-densityIndex
+    //   ring    - gaussian around the middle of the annulus, 1/6 of its width as deviation, clipped to it
+    //   cluster - Plummer sphere of scale radius outerRadius (cut at 10 scale radii), in virial equilibrium
+    enum class shape{ disk, ring, cluster };
+
+    struct population{
+        shape kind = shape::disk;
+        std::size_t count = 0;
+        std::string prefix = "p";           // bodies are named prefix + index
+        std::uint64_t seed = 1;
+        double innerRadius = 0, outerRadius = 0;    // [m]
+        double densityIndex = 1;
+        // bodies - log-uniform masses, radii from the bulk density
+        double minMass = 0, maxMass = 0;    // [kg]
+        double density = 2000;              // [kg m^-3]
+        double temperature = 0;             // [K]
+        // Keplerian orbits around the pivots (disk and ring) - uniform eccentricity, inclination (3D only) and true anomaly
+        double maxEccentricity = 0;
+        double maxInclination = 0;          // [rad]
+        bool inverted = false;
+    };
+
+    // Centre of mass of the pivots
+    template <std::size_t D>
+    struct origin{
+        vec<double,D> position, velocity;
+        double mass = 0;
+    };
+
+    // Bodies first ... last-1 of a population, generated in parallel
+    template <std::size_t D>
+    std::vector<basicBody<D>> generate(const population& p, const origin<D>& o, std::size_t first, std::size_t last);
+
+}
+
+#endif
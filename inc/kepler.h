@@ -0,0 +1,72 @@
+#ifndef __KEPLER__
+#define __KEPLER__
+
+#include <cmath>
+#include "vec.h"
+
+// Two-body propagation - exact Kepler drift of a relative orbit in universal variables,
+// valid for elliptic, parabolic and hyperbolic motion alike.
+namespace kepler{
+
+    // Stumpff functions C(z) and S(z), series near z = 0 to avoid cancellation
+    inline void stumpff(double z, double& C, double& S){
+        if (std::abs(z) < 1e-2){
+            C = 1./2 - z/24 + z*z/720 - z*z*z/40320;
+            S = 1./6 - z/120 + z*z/5040 - z*z*z/362880;
+        }else if (z > 0){
+            double s = std::sqrt(z);
+            C = (1-std::cos(s))/z;
+            S = (s-std::sin(s))/(s*s*s);
+        }else{
+            double s = std::sqrt(-z);
+            C = (std::cosh(s)-1)/(-z);
+            S = (std::sinh(s)-s)/(s*s*s);
+        }
+    }
+
+    // Advance relative position r and velocity v by dt around a gravitational parameter mu = G(m1+m2)
+    template <std::size_t D>
+    void drift(vec<double,D>& r, vec<double,D>& v, double mu, double dt){
+        double r0 = r.size();
+        if (r0 == 0 || mu <= 0 || dt == 0){ r = r + dt*v; return; }
+        double sqrtMu = std::sqrt(mu);
+        double sigma = (r*v)/sqrtMu;            // r0*vr0/sqrt(mu)
+        double alpha = 2/r0 - (v*v)/mu;         // inverse semi-major axis
+        double C, S;
+        // Kepler's equation in the universal anomaly x: F(x) = sqrt(mu)*dt, F is increasing since F' = |r(x)| > 0
+        auto F = [&](double x, double& dF){
+            stumpff(alpha*x*x, C, S);
+            dF = sigma*x*(1-alpha*x*x*S) + (1-alpha*r0)*x*x*C + r0;
+            return sigma*x*x*C + (1-alpha*r0)*x*x*x*S + r0*x - sqrtMu*dt;
+        };
+        // bracket the root, then Newton steps safeguarded by bisection
+        double dF;
+        double guess = sqrtMu*std::abs(dt)/r0;
+        double lo = dt > 0 ? 0 : -guess, hi = dt > 0 ? guess : 0;
+        while (F(hi, dF) < 0) { lo = hi; hi *= 2; }
+        while (F(lo, dF) > 0) { hi = lo; lo *= 2; }
+        double x = alpha > 0 ? sqrtMu*alpha*dt : 0.5*(lo+hi);
+        if (x <= lo || x >= hi) x = 0.5*(lo+hi);
+        for (int k = 0; k < 100; k++){
+            double f = F(x, dF);
+            if (f < 0) lo = x; else hi = x;
+            double next = x - f/dF;
+            if (!(next > lo && next < hi)) next = 0.5*(lo+hi);
+            if (std::abs(next-x) <= 1e-15*std::max(1.0,std::abs(x))){ x = next; break; }
+            x = next;
+        }
+        // Lagrange coefficients
+        stumpff(alpha*x*x, C, S);
+        double f = 1 - x*x/r0*C;
+        double g = dt - x*x*x*S/sqrtMu;
+        vec<double,D> r1 = f*r + g*v;
+        double r1s = r1.size();
+        double fdot = sqrtMu/(r1s*r0)*(alpha*x*x*x*S - x);
+        double gdot = 1 - x*x/r1s*C;
+        v = fdot*r + gdot*v;
+        r = r1;
+    }
+
+}
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef __OUTPUT__
+#define __OUTPUT__
+
+#include <string>
+#include <vector>
+
+// Output backend - draws recorded series as graphs and saves them to disk.
+// Implementations are plugins, loaded the first time plots are needed.
+class outputBackend{
+public:
+    virtual ~outputBackend() = default;
+    // line graph of y against x, saved to `path` (the extension selects the format)
+    virtual void plot(const std::string& path, const std::string& title, const std::string& xLabel, const std::string& yLabel,
+      const std::vector<double>& x, const std::vector<double>& y, int color) = 0;
+};
+
+// Plugin entry point - every backend plugin exports this symbol
+extern "C" typedef outputBackend* (*createOutputBackendFunction)();
+#define OUTPUT_BACKEND_ENTRY "createOutputBackend"
+
+// Load the plotting plugin on first use (dlopen). Searched in $STABLE_PLANETS_OUTPUT_PLUGIN, then
+// plugins/libroot_output.so next to the executable, then the library path. nullptr if none could be loaded.
+outputBackend* loadOutputBackend();
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef __PARALLEL__
+#define __PARALLEL__
+
+#include <vector>
+#include <utility>
+#include <cstddef>
+#include <functional>
+
+// Distributed-memory helpers - thin wrappers over MPI when built with STABLE_PLANETS_MPI,
+// otherwise a single rank owning everything. Threads within a rank go through forEach.
+namespace parallel{
+
+    void init(int* argc, char*** argv);
+    void finalize();
+    int rank();
+    int ranks();
+    // contiguous block [first,last) of n items owned by a rank
+    std::pair<std::size_t,std::size_t> block(std::size_t n, int r);
+    inline std::pair<std::size_t,std::size_t> block(std::size_t n) { return block(n, rank()); }
+    // gather every rank's block of n items (stride doubles each) into all ranks
+    void allgather(const std::vector<double>& local, std::vector<double>& global, std::size_t n, std::size_t stride);
+    // run fn(0) ... fn(count-1) on up to `threads` threads of this rank (0 for one per hardware thread)
+    void forEach(std::size_t count, const std::function<void(std::size_t)>& fn, int threads = 0);
+
+}
+
+#endif
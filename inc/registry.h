@@ -0,0 +1,79 @@
+#ifndef __REGISTRY__
+#define __REGISTRY__
+
+#include <vector>
+#include <string>
+#include <span>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+
+// Registry class - densely stored named items with stable integer IDs.
+// Lookup by ID or name is O(1); deletion swaps the last item into the freed slot.
+template <typename T>
+class registry{
+
+public:
+    using id = std::uint32_t;
+    static constexpr id invalid = std::numeric_limits<id>::max();
+
+private:
+    std::vector<T> items;                           // dense storage
+    std::vector<id> ids;                            // dense index -> id
+    std::vector<std::size_t> slots;                 // id -> dense index
+    std::unordered_map<std::string,id> names;       // name -> id
+    static constexpr std::size_t empty = std::numeric_limits<std::size_t>::max();
+
+    std::size_t slot(id i) const {
+        if (!contains(i)) throw std::out_of_range("registry: unknown id "+std::to_string(i));
+        return slots[i];
+    }
+
+public:
+    // Insert an item, returns its ID or invalid if the name is already taken
+    id insert(T item){
+        if (names.count(item.getName())) return invalid;
+        id i = slots.size();
+        slots.push_back(items.size());
+        ids.push_back(i);
+        names.emplace(item.getName(), i);
+        items.push_back(std::move(item));
+        return i;
+    }
+    // Remove an item - O(1), the last item takes its place in the dense storage
+    bool erase(id i){
+        if (!contains(i)) return false;
+        std::size_t slot = slots[i];
+        names.erase(items[slot].getName());
+        if (slot != items.size()-1){
+            items[slot] = std::move(items.back());
+            ids[slot] = ids.back();
+            slots[ids[slot]] = slot;
+        }
+        items.pop_back();
+        ids.pop_back();
+        slots[i] = empty;
+        return true;
+    }
+    bool erase(const std::string& name){ return erase(find(name)); }
+    void clear(){ items.clear(); ids.clear(); slots.clear(); names.clear(); }
+    void reserve(std::size_t n){ items.reserve(n); ids.reserve(n); slots.reserve(n); names.reserve(n); }
+    // Lookup
+    id find(const std::string& name) const { auto it = names.find(name); return it == names.end() ? invalid : it->second; }
+    bool contains(id i) const { return i < slots.size() && slots[i] != empty; }
+    // unknown or erased IDs throw std::out_of_range
+    T& at(id i){ return items[slot(i)]; }
+    const T& at(id i) const { return items[slot(i)]; }
+    // Dense access - indices are invalidated by erase, IDs are not
+    std::size_t size() const { return items.size(); }
+    T& operator[](std::size_t index){ return items[index]; }
+    const T& operator[](std::size_t index) const { return items[index]; }
+    id idAt(std::size_t index) const { return ids[index]; }
+    std::size_t indexOf(id i) const { return slot(i); }
+    std::span<T> data(){ return items; }
+    std::span<const T> data() const { return items; }
+
+};
+
+#endif
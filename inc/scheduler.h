@@ -0,0 +1,93 @@
+#ifndef __SCHEDULER__
+#define __SCHEDULER__
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <functional>
+
+#include "sys.h"
+
+// Job states
+enum class jobState{ queued, running, done, cancelled };
+
+// Job - one run of an immutable snapshot of a system, with its own result (released once the output is written)
+class job{
+
+public:
+    using id = int;
+
+    const id number;
+    const std::string label;
+    const sys snapshot;
+    const double duration, timeStep;
+    sys result;
+    std::atomic<int> priority;
+    std::atomic<int> progress {0};
+    std::atomic<jobState> state {jobState::queued};
+    std::atomic<bool> cancelled {false};
+
+    job(id n, std::string l, const sys& s, double T, double dT, int p)
+    : number(n), label(l), snapshot(s), duration(T), timeStep(dT), priority(p)
+    {}
+
+};
+
+// Job summary - what the GUI lists
+struct jobInfo{
+    job::id number;
+    std::string label;
+    int priority, progress;
+    jobState state;
+};
+
+// Scheduler - runs queued jobs on a fixed pool of threads, at most `slots` at a time.
+// The highest priority job runs first; ties are broken by submission order.
+class scheduler{
+
+public:
+    // called from a worker thread when a job changes (progress, start, end)
+    using listener = std::function<void(const job&)>;
+    // called from a worker thread once the job is solved, to produce its output
+    using finisher = std::function<void(job&)>;
+
+private:
+    std::vector<std::shared_ptr<job>> jobs;
+    std::vector<std::thread> workers;
+    mutable std::mutex lock;
+    std::condition_variable wake;
+    int slots, running = 0;
+    job::id nextId = 1;
+    bool stopping = false;
+    listener onChange;
+    finisher onFinish;
+    void work();
+    std::shared_ptr<job> next();
+
+public:
+    scheduler(int s = 1, listener change = {}, finisher finish = {});
+    ~scheduler();
+    scheduler(const scheduler&) = delete;
+    scheduler& operator=(const scheduler&) = delete;
+    // queue a run of a copy of the system
+    job::id submit(const sys& s, double T, double dT, int priority = 0, std::string label = "");
+    bool cancel(job::id n);
+    bool setPriority(job::id n, int priority);
+    std::shared_ptr<const job> get(job::id n) const;
+    std::vector<jobInfo> list() const;
+    // forget finished and cancelled jobs, returns how many were removed
+    std::size_t clearFinished();
+    // concurrent runs, between 1 and the pool size
+    void setSlots(int s);
+    int getSlots() const;
+    int poolSize() const { return workers.size(); }
+
+};
+
+std::string toString(jobState s);
+
+#endif
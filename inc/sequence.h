@@ -0,0 +1,60 @@
+#ifndef __SEQUENCE__
+#define __SEQUENCE__
+
+#include <coroutine>
+#include <exception>
+#include <iterator>
+#include <utility>
+
+// Lazy sequence produced by a coroutine - each value is computed when the caller advances to it and lives until
+// the next one is requested. Dropping the sequence part way ends the coroutine there. Move-only, single pass.
+template <typename T>
+class sequence{
+public:
+
+    struct promise_type{
+        T value;
+        std::exception_ptr error;
+        sequence get_return_object(){ return sequence(handle::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        std::suspend_always yield_value(T v){ value = std::move(v); return {}; }
+        void return_void(){}
+        void unhandled_exception(){ error = std::current_exception(); }
+    };
+    using handle = std::coroutine_handle<promise_type>;
+
+    class iterator{
+    private:
+        handle h;
+        void resume(){ h.resume(); if (h.promise().error) std::rethrow_exception(h.promise().error); }
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        iterator() = default;
+        explicit iterator(handle coroutine) : h(coroutine) { resume(); }
+        const T& operator* () const { return h.promise().value; }
+        const T* operator-> () const { return &h.promise().value; }
+        iterator& operator++ (){ resume(); return *this; }
+        void operator++ (int){ ++*this; }
+        bool operator== (std::default_sentinel_t) const { return !h || h.done(); }
+    };
+
+private:
+    handle h;
+    explicit sequence(handle coroutine) : h(coroutine) {}
+
+public:
+    sequence(sequence&& s) noexcept : h(std::exchange(s.h, {})) {}
+    sequence& operator= (sequence&& s) noexcept { if (this != &s){ if (h) h.destroy(); h = std::exchange(s.h, {}); } return *this; }
+    sequence(const sequence&) = delete;
+    sequence& operator= (const sequence&) = delete;
+    ~sequence(){ if (h) h.destroy(); }
+    // the coroutine starts running at begin, which may be called once
+    iterator begin(){ return iterator(h); }
+    std::default_sentinel_t end() const { return {}; }
+
+};
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef __SERIES__
+#define __SERIES__
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <memory>
+#include <iostream>
+
+// Recorded series - a fixed number of series sampled together, one value of each per sample. Samples stay in
+// memory while the store fits its budget. Past it, the samples held in memory are compressed series by series
+// into a segment appended to a spill file, and memory starts over. Series are read back one at a time, segment by
+// segment. Copies share the spill file, which is removed with the last of them.
+class seriesStore{
+
+private:
+    class spillFile;
+    struct chunk{ std::uint64_t offset = 0, size = 0; };
+    struct segment{ std::size_t samples = 0; std::vector<chunk> chunks; };
+    std::size_t count = 0, samples = 0;
+    std::uintmax_t budget = 0;              // [bytes], 0 for no limit
+    std::string directory;                  // of the spill file, "" for the system temporary directory
+    std::vector<std::vector<double>> memory;    // samples not spilled, per series
+    std::vector<segment> segments;
+    std::shared_ptr<spillFile> file;
+    std::size_t held() const {return memory.empty() ? 0 : memory[0].size();}
+    std::size_t segmentLength() const;
+    void spill();
+    bool readSegment(const segment& s, std::size_t k, std::vector<double>& out) const;
+
+public:
+    seriesStore() = default;
+    // Start over with `series` empty series - the spill file of the previous samples is let go
+    void open(std::size_t series, std::uintmax_t limit = 0, const std::string& spillDirectory = "");
+    // Room for `total` samples, reserved exactly when they fit in the budget and for one segment otherwise
+    void reserve(std::size_t total);
+    // Append one value of every series
+    void push(const std::vector<double>& sample);
+    // Append the samples of a store with the same series
+    void append(const seriesStore& other);
+    std::size_t series() const {return count;}
+    std::size_t size() const {return samples;}
+    bool isSpilled() const {return !segments.empty();}
+    // Series s, from the spill file and memory
+    std::vector<double> get(std::size_t s) const;
+    // Bytes held in memory and in the spill file
+    std::uintmax_t memoryUsage() const;
+    std::uintmax_t diskUsage() const;
+    // Uncompressed size of `series` series of `length` samples [bytes]
+    static std::uintmax_t bytes(std::size_t series, std::size_t length){return std::uintmax_t(series)*length*sizeof(double);}
+    // Binary form of every series, streamed one series at a time; reading spills within the budget of this store
+    void write(std::ostream& out) const;
+    bool read(std::istream& in);
+
+};
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef __STATS__
+#define __STATS__
+
+#include <limits>
+#include <cmath>
+
+// Running statistic - O(1) memory min/max/mean of a scalar quantity, updated sample by sample
+class runningStat{
+
+private:
+    long count = 0;
+    double mean = 0;
+    double min = std::numeric_limits<double>::infinity();
+    double max = -std::numeric_limits<double>::infinity();
+
+public:
+    // update
+    void push(double x){
+        count++;
+        mean += (x-mean)/count;
+        if (x < min) min = x;
+        if (x > max) max = x;
+    }
+    // getters
+    long getCount() const { return count; }
+    double getMean() const { return mean; }
+    double getMin() const { return min; }
+    double getMax() const { return max; }
+    double getRange() const { return max-min; }
+    // combine with the statistic of another stretch of samples
+    void merge(const runningStat& o){
+        if (o.count == 0) return;
+        long n = count+o.count;
+        mean += (o.mean-mean)*o.count/n;
+        count = n;
+        if (o.min < min) min = o.min;
+        if (o.max > max) max = o.max;
+    }
+
+};
+
+// Orbit statistic - streaming analysis of the distance between two bodies.
+// Local minima/maxima of the distance are taken as periapsis/apoapsis passages.
+class orbitStat{
+
+private:
+    runningStat distance;
+    runningStat periapses, apoapses;
+    // last two samples, needed to detect local extrema
+    double previous = 0, beforePrevious = 0;
+    double previousTime = 0;
+    long samples = 0;
+    // periapsis passage timing
+    double firstPeriapsisTime = 0, lastPeriapsisTime = 0;
+    // first two samples, needed to detect extrema across a merge
+    double first = 0, second = 0, firstTime = 0;
+    void extremum(double before, double x, double after, double t);
+
+public:
+    // update
+    void push(double t, double d);
+    // append the statistic of the samples that directly follow these
+    void merge(const orbitStat& o);
+    // getters
+    const runningStat& getDistance() const { return distance; }
+    double getPeriapsis() const { return distance.getMin(); }
+    double getApoapsis() const { return distance.getMax(); }
+    long getOrbits() const { return periapses.getCount() > 0 ? periapses.getCount()-1 : 0; }
+    // estimates - 0 when no full orbit was observed
+    double getPeriod() const;
+    double getEccentricity() const;
+
+};
+
+#endif
@@ -3,53 +3,270 @@
 
 #include <vector>
 #include <string>
+#include <functional>
+#include <atomic>
+#include <memory>
+#include <array>
+#include <fstream>
 
 #include "body.h"
-#include "vec2.h"
+#include "vec.h"
+#include "stats.h"
+#include "registry.h"
+#include "cache.h"
+#include "generator.h"
+#include "events.h"
+#include "sequence.h"
+#include "series.h"
 
-#include "TGraph.h"
-#include "TMultiGraph.h"
-#include "TCanvas.h"
-#include "TAxis.h"
-#include "TStyle.h"
-#include "TLatex.h"
+// Stop criteria - a run is stopped early as soon as one of these fires. A value of 0 disables the criterion.
+struct stopCriteria{
+    double escapeRadius = 0;    // bodies beyond this distance from the C.M. and faster than escape speed are ejected [m]
+    double hillFactor = 0;      // close encounter when two bodies get closer than hillFactor mutual Hill radii
+    double energyDrift = 0;     // maximum relative drift of the total energy
+    double momentumDrift = 0;   // maximum relative drift of the total angular momentum
+    bool warnOnDrift = false;   // the two drift tolerances only warn
+    bool collisions = false;    // stop when two bodies touch (merge)
+    int checkInterval = 1;      // steps between two checks
+};
+
+// Stop reasons
+enum class stopReason{ none, ejection, closeEncounter, collision, conservation, cancelled };
+
+// Parareal - parallel-in-time integration of a single system. The run is cut into time slices that the fine
+// (normal) integrator solves concurrently, each from a start state predicted by a coarse integrator with a longer
+// step; the predictions are corrected and the slices solved again until their start states stop changing.
+struct pararealOptions{
+    bool enabled = false;
+    int slices = 0;             // time slices, 0 for one per hardware thread
+    int coarseFactor = 4;       // coarse time step, in fine time steps
+    int maxIterations = 0;      // 0 for as many as slices, which reproduces the serial run exactly
+    double tolerance = 1e-10;   // relative change of the slice start states at which iterations stop
+    bool reference = false;     // also run serially, to measure the speedup and the deviation
+};
+
+// Outcome of a Parareal run
+struct pararealStats{
+    int slices = 0, iterations = 0;
+    bool converged = false;
+    double wallTime = 0;                // [s]
+    double referenceTime = 0;           // serial run, 0 when not run [s]
+    double deviation = 0;               // largest final position difference to the serial run [m]
+    std::vector<double> corrections;    // relative change of the slice start states, per iteration
+};
+
+// Progress reporting - receives a percentage and a status message
+using progressCallback = std::function<void(int, const std::string&)>;
 
 // Planetary System - This class holds all the information about the planets and is able to create simulations.
-class frame;
-class sys{
+// Generic over the spatial dimension D; instantiated for planar (2) and inclined (3) systems in sys.cpp.
+template <std::size_t D>
+class basicSys{
+public:
+    using body = basicBody<D>;
+    using vecD = vec<double,D>;
+    using bodyId = typename registry<body>::id;
+
 private:
 
     // Bodies
     std::vector<body> bodies;
-    std::vector<body> originalBodies;
-    std::vector<double> times;
-    // Data
-    std::vector<std::vector<std::vector<double>>> distanceToBodies;
-    std::vector<std::vector<double>> temperature;
-    std::vector<std::vector<double>> orbitalSpeed;
-    std::vector<std::vector<double>> orbitalAccel;
-    std::vector<std::vector<double>> xPositions;
-    std::vector<std::vector<double>> yPositions;
+    registry<body> originalBodies;
+    // Data - recorded series: time, energy and angular momentum drifts, temperature, speed and acceleration of
+    // each body, then the distance of each pair i < j. Past the memory budget they spill to disk.
+    seriesStore recorded;
+    std::vector<double> sample;
+    bool sampleHeld = false;    // sample of the last state, waiting for its drifts
+    std::uintmax_t memoryBudget = 0;
+    std::string spillDirectory;
+    bool recording = true;
+    static std::size_t seriesCount(std::size_t N){return 3+3*N+N*(N-1)/2;}
+    std::size_t bodySeries(std::size_t i) const {return 3+3*i;}
+    std::size_t pairSeries(std::size_t i, std::size_t j) const {return 3+3*bodies.size() + i*bodies.size()-i*(i+1)/2 + j-i-1;}
+    // Streaming statistics - kept even when recording is off
+    double duration = 0;
+    std::vector<runningStat> temperatureStats;
+    std::vector<runningStat> speedStats;
+    std::vector<std::vector<orbitStat>> orbitStats;
+    // Early termination
+    stopCriteria criteria;
+    stopReason stopped = stopReason::none;
+    std::string stopMessage;
+    double stopTime = 0;
+    const std::atomic<bool>* cancelToken = nullptr;
+    // Conservation monitor - energy and angular momentum of the state at the start of the last step,
+    // summed inside the force loop; drifts are sampled at the output cadence. A recorded sample is held until
+    // the next step has measured its state, the last one is measured separately when the run ends
+    double energy = 0, initialEnergy = 0;
+    vec3 momentum, initialMomentum;
+    double momentumScale = 0;
+    runningStat energyDriftStats, momentumDriftStats;
+    std::string driftWarning;
+    void measure();
+    void closeSample();
+    // Run progress - enough to continue a cached run
+    std::vector<double> previousSpeed;
+    double clock = 0;   // time of the next step
+    long steps = 0;
+    resultCache* cache = nullptr;
+    // Close encounters - Plummer softening length, and separation below which mutually nearest pairs
+    // are regularized: their relative orbit is drifted exactly (Kepler) while outside forces act as kicks [m]
+    double softening = 0;
+    double regularizationRadius = 0;
+    std::vector<int> partner;
+    void findPairs();
+    // centre of mass of a set of bodies, the frame new orbits are set up in
+    generator::origin<D> pivotOrigin(const std::vector<bodyId>& pivots) const;
+    // Event detection - the state at the start of the step, pending events and the log they are flushed to
+    eventOptions events;
+    std::vector<vecD> stepPositions, stepVelocities;
+    std::vector<event> pendingEvents;
+    std::shared_ptr<std::ofstream> eventLog;
+    std::array<long,eventTypes> eventCounts {};
+    int centre = -1, observer = -1;
+    void openEvents();
+    void detectEvents(double t, double dT);
+    void flushEvents();
+    // Keyframes - full states every keyframeInterval steps, any time of the run is rebuilt by integrating
+    // forward from the last keyframe before it
+    long keyframeInterval = 0;
+    double keyframeStep = 0;
+    std::vector<long> keyframeSteps;
+    std::vector<std::vector<body>> keyframes;
+    bool readKeyframes(std::istream& in, std::size_t count, std::size_t N);
+    // n steps of a state, nothing extracted
+    std::vector<body> propagate(const std::vector<body>& start, long n, double dT) const;
+    // Parareal
+    pararealOptions parareal;
+    pararealStats pararealResult;
+    void solveParareal(double T, double dT, progressCallback progress);
+    void append(basicSys& slice);
+    // batched runs drive the run state of their systems directly
+    template <std::size_t> friend class batch;
+    // Cache entries - the run, after the canonical input (initial state and solver parameters) it is keyed by
+    std::string canonicalInput(double dT) const;
+    void writeRun(std::ostream& out, const std::string& input) const;
+    bool readRun(std::istream& in, const std::string& input);
+    bool checkStop(double t);
+    // Run loop - state reset, allocation (for the expected samples) and extraction of the recorded data, and one
+    // full step of the run (integration, extraction, cancellation and stop checks) which returns false once the run stops
+    void reset();
+    // iterations of the run loop from `start` to T - the same additions as the loop, so the count is exact
+    static std::size_t stepsUntil(double start, double T, double dT);
+    void allocate(std::size_t expected = 0);
+    void extractData(double t, double dT);
+    bool step(double t, double dT, bool extract);
+    // Integration - one step of every body, distributed over the MPI ranks when there are several and every rank
+    // takes part (`distributed`)
+    void advance(double dT, bool distributed = true);
+    body evolve(int i, const vecD& accel, double dT) const;
 
 public:
 
     // Constructors
-    sys() = default;
-    ~sys() = default;
+    basicSys() = default;
+    ~basicSys() = default;
     // Getters
-    std::vector<body> getBodies(){return originalBodies;}
-    body operator[](const int& i){return originalBodies[i];}
-    int size () {return originalBodies.size();}
+    std::span<const body> getBodies() const {return originalBodies.data();}
+    const body& operator[](const int& i) const {return originalBodies[i];}
+    int size () const {return originalBodies.size();}
+    // Stable IDs - unaffected by deletion of other bodies
+    bodyId find(const std::string& name) const {return originalBodies.find(name);}
+    const body& getBody(bodyId id) const {return originalBodies.at(id);}
+    bodyId getId(int i) const {return originalBodies.idAt(i);}
+    // State reached by the last run
+    std::span<const body> getState() const {return bodies;}
+    // Statistics of the last run
+    const runningStat& getTemperatureStats(int i) const {return temperatureStats[i];}
+    const runningStat& getSpeedStats(int i) const {return speedStats[i];}
+    const orbitStat& getOrbitStats(int i, int j) const {return i < j ? orbitStats[i][j] : orbitStats[j][i];}
+    // Relative drift of the total energy and angular momentum
+    double getEnergyDrift() const {return initialEnergy != 0 ? std::abs((energy-initialEnergy)/initialEnergy) : 0;}
+    double getMomentumDrift() const {return momentumScale > 0 ? (momentum-initialMomentum).size()/momentumScale : 0;}
+    const runningStat& getEnergyDriftStats() const {return energyDriftStats;}
+    const runningStat& getMomentumDriftStats() const {return momentumDriftStats;}
+    // Toggle storage of the full time series (statistics are always computed)
+    void setRecording(bool r){recording = r;}
+    bool isRecording() const {return recording;}
+    // Memory budget of the recorded series [bytes], 0 for no limit - past it they spill to compressed segments
+    // in the spill directory ("" for the system temporary directory)
+    void setMemoryBudget(std::uintmax_t bytes, const std::string& directory = ""){memoryBudget = bytes; spillDirectory = directory;}
+    std::uintmax_t getMemoryBudget() const {return memoryBudget;}
+    // Memory the series recorded by a run of duration T take, uncompressed (0 when not recording) [bytes]
+    std::uintmax_t recordSize(double T, double dT) const;
+    // Early termination criteria and outcome of the last run
+    void setStopCriteria(const stopCriteria& c){criteria = c;}
+    const stopCriteria& getStopCriteria() const {return criteria;}
+    stopReason getStopReason() const {return stopped;}
+    std::string getStopMessage() const {return stopMessage;}
+    double getStopTime() const {return stopTime;}
+    // A run stops at its next step once the token is set
+    void setCancelToken(const std::atomic<bool>* token){cancelToken = token;}
+    // Completed runs are looked up in / stored to the cache; a cached shorter run is continued
+    void setCache(resultCache* c){cache = c;}
+    std::uint64_t cacheKey(double dT) const;
+    // Close encounter handling, 0 disables (regularization is not applied under MPI)
+    void setSoftening(double eps){softening = eps;}
+    double getSoftening() const {return softening;}
+    void setRegularizationRadius(double r){regularizationRadius = r;}
+    double getRegularizationRadius() const {return regularizationRadius;}
+    // Events found during a run, streamed to a log (runs with events bypass the cache)
+    void setEvents(const eventOptions& e){events = e;}
+    const eventOptions& getEvents() const {return events;}
+    long getEventCount(eventType t) const {return eventCounts[int(t)];}
+    // Keyframes of the run, a full state every `interval` steps (0 disables) - random access to any time
+    void setKeyframeInterval(long interval){keyframeInterval = interval;}
+    long getKeyframeInterval() const {return keyframeInterval;}
+    std::size_t getKeyframeCount() const {return keyframes.size();}
+    // state at a time of the run, 0 to its duration (empty outside it)
+    std::vector<body> stateAt(double t) const;
+    double getDuration() const {return duration;}
+    bool saveKeyframes(const std::string& path) const;
+    bool loadKeyframes(const std::string& path);
+    // Parallel-in-time integration, used by solve when enabled (not under MPI, and without the cache)
+    void setParareal(const pararealOptions& p){parareal = p;}
+    const pararealOptions& getParareal() const {return parareal;}
+    const pararealStats& getPararealStats() const {return pararealResult;}
     // Remove body from the planetary system.
-    void deleteBody(std::string name);
-    // Add a body to the planetary system
-    void linkBody (body b);
-    void linkBody(double mass, double radius, double distance, std::vector<std::string> pivots,
-      double angularVelocity, std::string name, double temperature, bool heatSource, double orbitalAngle, bool inverted, double dayAngle);
-    // data analysis
-    void solve(double T, double dT, frame* f);
-    void saveData(frame* f,std::string append="", std::string time_units="s", std::string distance_units="m", double time_convert=1., double distance_convert=1.);
+    void deleteBody(const std::string& name);
+    void deleteBody(bodyId id);
+    // Add a body to the planetary system, returns its ID (registry<body>::invalid if the name is taken).
+    // The orbit is around the centre of mass of the pivots; the inclination tilts it out of the x-y plane (3D only)
+    bodyId linkBody (body b);
+    bodyId linkBody(double mass, double radius, double distance, const std::vector<std::string>& pivots,
+      double angularVelocity, std::string name, double temperature, bool heatSource, double orbitalAngle, bool inverted, double dayAngle,
+      double inclination = 0);
+    bodyId linkBody(double mass, double radius, double distance, const std::vector<bodyId>& pivots,
+      double angularVelocity, std::string name, double temperature, bool heatSource, double orbitalAngle, bool inverted, double dayAngle,
+      double inclination = 0);
+    // Add a generated population orbiting the pivots, returns the number of bodies added
+    std::size_t generate(const generator::population& p, const std::vector<bodyId>& pivots = {});
+    // Write the bodies and a generated population to a binary .sys file, without keeping the population in memory
+    bool generateFile(const generator::population& p, const std::string& path, const std::vector<bodyId>& pivots = {}) const;
+    // .sys files - text, or binary for large systems (recognised on load)
+    bool load(const std::string& path);
+    bool save(const std::string& path, bool binaryFormat = false) const;
+    // data analysis - with MPI every rank integrates, rank 0 records and writes
+    void solve(double T, double dT, progressCallback progress = {});
+    // State during a lazy run - the bodies are valid until the run is advanced again
+    struct stateView{
+        double time = 0;
+        long step = 0;
+        std::span<const body> bodies;
+        double energyDrift = 0, momentumDrift = 0;
+    };
+    // Lazy run - yields the state at t = 0, every `every` steps and at the end, each computed when the caller
+    // asks for it. Nothing is recorded or cached; stop criteria and cancellation apply, and the outcome is
+    // available once the sequence is exhausted. The system must outlive the sequence.
+    sequence<stateView> run(double T, double dT, long every = 1);
+    std::string report();
+    void saveReport(std::string path);
+    void saveData(progressCallback progress = {}, std::string append="", std::string time_units="s", std::string distance_units="m", double time_convert=1., double distance_convert=1.);
 
 };
 
+// Planar and inclined planetary systems
+using sys = basicSys<2>;
+using sys3 = basicSys<3>;
+
 #endif
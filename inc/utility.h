@@ -36,7 +36,24 @@ enum {
     ID_Save = 27,
     ID_Load = 28,
     PROGRESS = 29,
-    STATUS = 30
+    STATUS = 30,
+    ID_Record = 31,
+    ID_EscapeRadius = 32,
+    ID_HillFactor = 33,
+    ID_EnergyDrift = 34,
+    ID_Collisions = 35,
+    ID_JobList = 36,
+    ID_CancelJob = 37,
+    ID_RaisePriority = 38,
+    ID_LowerPriority = 39,
+    ID_Slots = 40,
+    JOBS = 41,
+    ID_Softening = 42,
+    ID_Regularization = 43,
+    ID_MomentumDrift = 44,
+    ID_DriftWarn = 45,
+    ID_MemoryBudget = 46,
+    ID_ClearJobs = 47
 };
 
 double lengthSI(int i);
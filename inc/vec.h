@@ -0,0 +1,56 @@
+#ifndef __VEC__
+#define __VEC__
+
+#include <cmath>
+#include <array>
+#include <cstddef>
+
+// D-dimensional vector class - holds basic vector operations.
+// Header-only and constexpr so the operators inline into the force loop.
+template <typename T, std::size_t D>
+class vec{
+private:
+    std::array<T,D> c{};
+public:
+    constexpr vec() noexcept = default;
+    template <typename... Args> requires (sizeof...(Args) == D)
+    constexpr vec(Args... args) noexcept : c{T(args)...} {}
+    // component access
+    constexpr T& operator[] (std::size_t i) noexcept { return c[i]; }
+    constexpr const T& operator[] (std::size_t i) const noexcept { return c[i]; }
+    constexpr T X() const noexcept requires (D >= 1) { return c[0]; }
+    constexpr T Y() const noexcept requires (D >= 2) { return c[1]; }
+    constexpr T Z() const noexcept requires (D >= 3) { return c[2]; }
+    static constexpr std::size_t dimension() noexcept { return D; }
+    // arithmetic
+    constexpr T operator* (const vec& v) const noexcept { T s = 0; for (std::size_t i = 0; i < D; i++) s += c[i]*v.c[i]; return s; }
+    constexpr vec operator+ (const vec& v) const noexcept { vec r; for (std::size_t i = 0; i < D; i++) r.c[i] = c[i]+v.c[i]; return r; }
+    constexpr vec operator- (const vec& v) const noexcept { vec r; for (std::size_t i = 0; i < D; i++) r.c[i] = c[i]-v.c[i]; return r; }
+    constexpr vec operator- () const noexcept { vec r; for (std::size_t i = 0; i < D; i++) r.c[i] = -c[i]; return r; }
+    constexpr vec operator* (const T& k) const noexcept { vec r; for (std::size_t i = 0; i < D; i++) r.c[i] = c[i]*k; return r; }
+    constexpr vec operator/ (const T& k) const noexcept { vec r; for (std::size_t i = 0; i < D; i++) r.c[i] = c[i]/k; return r; }
+    constexpr vec& operator+= (const vec& v) noexcept { for (std::size_t i = 0; i < D; i++) c[i] += v.c[i]; return *this; }
+    constexpr vec& operator-= (const vec& v) noexcept { for (std::size_t i = 0; i < D; i++) c[i] -= v.c[i]; return *this; }
+    constexpr vec& operator*= (const T& k) noexcept { for (std::size_t i = 0; i < D; i++) c[i] *= k; return *this; }
+    friend constexpr vec operator* (const T& k, const vec& v) noexcept { return v*k; }
+    constexpr bool operator== (const vec& v) const noexcept = default;
+    // norms
+    T size() const noexcept { return std::sqrt((*this)*(*this)); }
+    vec normalized() const noexcept { return (1/size())*(*this); }
+};
+
+// Cross product - planar vectors give the z axis component
+template <typename T>
+constexpr vec<T,3> cross(const vec<T,3>& a, const vec<T,3>& b) noexcept {
+    return vec<T,3>(a[1]*b[2]-a[2]*b[1], a[2]*b[0]-a[0]*b[2], a[0]*b[1]-a[1]*b[0]);
+}
+template <typename T>
+constexpr vec<T,3> cross(const vec<T,2>& a, const vec<T,2>& b) noexcept {
+    return vec<T,3>(T(0), T(0), a[0]*b[1]-a[1]*b[0]);
+}
+
+// Common vector types
+using vec2 = vec<double,2>;
+using vec3 = vec<double,3>;
+
+#endif
@@ -0,0 +1,37 @@
+#include "output.h"
+
+#include "TGraph.h"
+#include "TCanvas.h"
+#include "TAxis.h"
+#include "TStyle.h"
+
+// ROOT output backend - PDF line graphs, built as plugins/libroot_output.so
+class rootOutput: public outputBackend{
+
+private:
+    TCanvas canvas;
+
+public:
+    rootOutput() : canvas("","",1080,480) {
+        // grid style
+        gStyle->SetGridStyle(0);
+        gStyle->SetGridColor(17);
+    }
+
+    void plot(const std::string& path, const std::string& title, const std::string& xLabel, const std::string& yLabel,
+      const std::vector<double>& x, const std::vector<double>& y, int color) override {
+        TGraph graph(x.size(),x.data(),y.data());
+        graph.SetLineColor(color);
+        graph.SetTitle((title+";"+xLabel+";"+yLabel).c_str());
+        graph.Draw("AL"); gPad->SetGrid();
+        canvas.Modified();
+        canvas.Update();
+        canvas.SaveAs(path.c_str(),"pdf");
+        canvas.Clear();
+    }
+
+};
+
+extern "C" outputBackend* createOutputBackend(){
+    return new rootOutput();
+}
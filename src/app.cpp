@@ -4,7 +4,7 @@
 wxIMPLEMENT_APP(app);
 
 bool app::OnInit(){
-    frame *f = new frame("StablePlanets",wxPoint(0,0), wxSize(720, 480));
+    frame *f = new frame("StablePlanets",wxPoint(0,0), wxSize(720, 600));
     f->Center();
     f->Show( true );
     return true;
@@ -0,0 +1,190 @@
+#include "batch.h"
+#include "parallel.h"
+#include "def.h"
+
+#include <iostream>
+#include <algorithm>
+#include <mutex>
+#include <cmath>
+
+namespace{
+
+// Forces on the bodies of a block, component c of body i in lane l at (i*D + c)*W + l, and the kinetic energy,
+// potential and angular momentum of every lane - the operations of basicSys::advance, one lane per SIMD lane
+template <std::size_t D, std::size_t W, bool soft>
+void forces(std::size_t N, const double* __restrict mass, const double* __restrict x, const double* __restrict v, double* __restrict a,
+  double softening2, double* __restrict kinetic, double* __restrict potential, double* __restrict angular){
+    for (std::size_t i = 0; i < N; i++){
+        const double* mi = mass+i*W;
+        const double* xi = x+i*D*W;
+        const double* vi = v+i*D*W;
+        double* ai = a+i*D*W;
+        for (std::size_t l = 0; l < W; l++){
+            double vv = 0;
+            #pragma GCC unroll 3
+            for (std::size_t c = 0; c < D; c++) vv += vi[c*W+l]*vi[c*W+l];
+            kinetic[l] += 0.5*mi[l]*vv;
+        }
+        if constexpr (D >= 3) for (std::size_t l = 0; l < W; l++){
+            angular[l] += (xi[W+l]*vi[2*W+l]-xi[2*W+l]*vi[W+l])*mi[l];
+            angular[W+l] += (xi[2*W+l]*vi[l]-xi[l]*vi[2*W+l])*mi[l];
+            angular[2*W+l] += (xi[l]*vi[W+l]-xi[W+l]*vi[l])*mi[l];
+        }
+        else for (std::size_t l = 0; l < W; l++) angular[2*W+l] += (xi[l]*vi[W+l]-xi[W+l]*vi[l])*mi[l];
+        // pairwise forces, every lane at once
+        for (std::size_t j = i+1; j < N; j++){
+            const double* mj = mass+j*W;
+            const double* xj = x+j*D*W;
+            double* aj = a+j*D*W;
+            // rows of different bodies never overlap
+            #pragma GCC ivdep
+            for (std::size_t l = 0; l < W; l++){
+                const double dx = xj[l] - xi[l], dy = xj[W+l] - xi[W+l];
+                const double dz = D >= 3 ? xj[2*W+l] - xi[2*W+l] : 0;
+                double d2 = dx*dx + dy*dy;
+                if constexpr (D >= 3) d2 += dz*dz;
+                d2 = d2 + softening2;
+                const double d = sqrt(d2), inv = 1/d;
+                potential[l] -= mi[l]*mj[l]/d;
+                const double q = mj[l]/d2, p = mi[l]/d2;
+                const double rx = soft ? dx/d : dx*inv, ry = soft ? dy/d : dy*inv, rz = soft ? dz/d : dz*inv;
+                ai[l] += rx*q; aj[l] -= rx*p;
+                ai[W+l] += ry*q; aj[W+l] -= ry*p;
+                if constexpr (D >= 3){ ai[2*W+l] += rz*q; aj[2*W+l] -= rz*p; }
+            }
+        }
+    }
+}
+
+// Symplectic Euler as in basicSys::evolve for n rows of W lanes - the mask is 1 for running lanes and 0 for
+// stopped ones, whose state then stays as it is (their forces, from that same state, stay finite)
+template <std::size_t W>
+void step(std::size_t n, double* __restrict x, double* __restrict v, const double* __restrict a, const double* __restrict mask, double dT){
+    for (std::size_t k = 0; k < n*W; k += W){
+        for (std::size_t l = 0; l < W; l++){
+            const double vel = v[k+l] + ((a[k+l]*G)*dT)*mask[l];
+            v[k+l] = vel;
+            x[k+l] = x[k+l] + (vel*dT)*mask[l];
+        }
+    }
+}
+
+}
+
+template <std::size_t D>
+bool batch<D>::add(const basicSys<D>& s){
+    if (s.size() == 0) return false;
+    if (systems.empty()){ N = s.size(); softening = s.getSoftening(); }
+    else if (std::size_t(s.size()) != N || s.getSoftening() != softening) return false;
+    systems.push_back(s);
+    return true;
+}
+
+template <std::size_t D>
+void batch<D>::solve(double T, double dT, progressCallback progress){
+    std::size_t blocks = (systems.size()+width-1)/width;
+    std::cout << "|| Solving " << systems.size() << " systems of " << N << " bodies in " << blocks << " blocks of " << width << " lanes ...\n";
+    if (std::any_of(systems.begin(), systems.end(), [](const basicSys<D>& s){ return s.regularizationRadius > 0; }))
+        std::cout << "Close pairs are not regularized in batches\n";
+    // the conservation monitor measures the start state with the forces of the batch
+    for (auto& s : systems) s.regularizationRadius = 0;
+    // blocks finish in any order, progress is their share
+    std::atomic<std::size_t> done {0};
+    std::mutex reporting;
+    parallel::forEach(blocks, [&](std::size_t b){
+        solveBlock(b, T, dT);
+        int percent = int(100*++done/blocks);
+        if (!progress) return;
+        std::lock_guard<std::mutex> lock (reporting);
+        progress(percent, "Calculating Trajectories... ("+std::to_string(percent)+" %)");
+    });
+    long stops = std::count_if(systems.begin(), systems.end(), [](const basicSys<D>& s){ return s.stopped != stopReason::none; });
+    if (stops > 0) std::cout << stops << " of " << systems.size() << " systems stopped early\n";
+    if (progress) progress(0, "Done!");
+    std::cout << "Done!\n";
+}
+
+template <std::size_t D>
+void batch<D>::solveBlock(std::size_t b, double T, double dT){
+    constexpr std::size_t W = width;
+    const std::size_t first = b*W, lanes = std::min(W, systems.size()-first);
+    const double softening2 = softening*softening;
+
+    // lane-interleaved state - component c of body i in lane l at (i*D + c)*W + l
+    std::vector<double> mass (N*W), x (N*D*W), v (N*D*W), a (N*D*W);
+    auto at = [](std::size_t i, std::size_t c, std::size_t l){ return (i*D + c)*W + l; };
+    std::array<double,W> active {};   // update mask, 1 while the lane runs
+    for (std::size_t l = 0; l < W; l++){
+        // padding lanes repeat the last system and never run
+        basicSys<D>& s = systems[first+std::min(l, lanes-1)];
+        if (l < lanes){ s.reset(); active[l] = 1; }
+        for (std::size_t i = 0; i < N; i++){
+            const body& o = s.bodies[i];
+            mass[i*W+l] = o.getMass();
+            for (std::size_t c = 0; c < D; c++){ x[at(i,c,l)] = o.getPosition()[c]; v[at(i,c,l)] = o.getVelocity()[c]; }
+        }
+    }
+    bool started = false;
+    // state of a lane back into its system, after the step just taken - the spin angle follows basicSys::evolve,
+    // temperatures are not evolved
+    auto scatter = [&](std::size_t l){
+        basicSys<D>& s = systems[first+l];
+        for (std::size_t i = 0; i < N; i++){
+            const body& o = s.bodies[i];
+            vec<double,D> pos, vel, acc;
+            for (std::size_t c = 0; c < D; c++){ pos[c] = x[at(i,c,l)]; vel[c] = v[at(i,c,l)]; acc[c] = a[at(i,c,l)]*G; }
+            double angle = o.getAngle();
+            if (!started) acc = o.getAcceleration();
+            else{ angle = dT*o.getAngularVelocity(); while (angle>2*PI) angle-=2*PI; while (angle < 0) angle+= 2*PI; }
+            s.bodies[i] = body(o.getMass(),o.getRadius(),pos,vel,acc,o.getAngularVelocity(),o.getName(),o.getTemperature(),o.getIsHeatSource(),angle);
+        }
+    };
+    // checks that look at the bodies, not only at the conservation monitor
+    auto needsState = [](const stopCriteria& c){ return c.escapeRadius > 0 || c.hillFactor > 0 || c.collisions; };
+
+    // conserved quantities of the current state, summed along the force loop as in basicSys::advance
+    std::array<double,W> kinetic, potential;
+    std::array<double,3*W> angular;
+
+    std::size_t running = lanes;
+    for (double t = 0; t < T && running > 0; t += dT){
+        kinetic.fill(0); potential.fill(0); angular.fill(0);
+        std::fill(a.begin(), a.end(), 0.);
+        if (softening2 > 0) forces<D,W,true>(N, mass.data(), x.data(), v.data(), a.data(), softening2, kinetic.data(), potential.data(), angular.data());
+        else forces<D,W,false>(N, mass.data(), x.data(), v.data(), a.data(), 0, kinetic.data(), potential.data(), angular.data());
+        step<W>(N*D, x.data(), v.data(), a.data(), active.data(), dT);
+        started = true;
+        // run state, cancellation and stop checks per lane - the same order as basicSys::step
+        for (std::size_t l = 0; l < lanes; l++){
+            if (!active[l]) continue;
+            basicSys<D>& s = systems[first+l];
+            s.energy = kinetic[l] + G*potential[l];
+            s.momentum = vec3(angular[l], angular[W+l], angular[2*W+l]);
+            s.steps++;
+            s.clock = t + dT;
+            if (cancelToken && *cancelToken){
+                s.stopped = stopReason::cancelled; s.stopMessage = "cancelled"; s.stopTime = s.clock;
+                scatter(l);
+                active[l] = 0; running--;
+                continue;
+            }
+            if (s.criteria.checkInterval > 0 && s.steps % s.criteria.checkInterval == 0){
+                if (needsState(s.criteria)) scatter(l);
+                if (s.checkStop(s.clock)){
+                    if (!needsState(s.criteria)) scatter(l);
+                    active[l] = 0; running--;
+                }
+            }
+        }
+    }
+    // stopped lanes were written back when they stopped
+    for (std::size_t l = 0; l < lanes; l++){
+        basicSys<D>& s = systems[first+l];
+        if (active[l] != 0) scatter(l);
+        s.duration = s.stopped == stopReason::none ? T : s.stopTime;
+    }
+}
+
+// Planar and inclined systems
+template class batch<2>;
+template class batch<3>;
@@ -0,0 +1,78 @@
+#include "cache.h"
+
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+
+resultCache::resultCache(std::string dir, std::uintmax_t limit)
+: directory(dir), maxBytes(limit)
+{}
+
+std::filesystem::path resultCache::path(std::uint64_t key) const {
+    std::stringstream name;
+    name << std::hex << std::setw(16) << std::setfill('0') << key << ".run";
+    return directory / name.str();
+}
+
+bool resultCache::load(std::uint64_t key, const std::function<bool(std::istream&)>& read){
+    std::lock_guard<std::mutex> guard(lock);
+    std::filesystem::path file = path(key);
+    std::ifstream input (file, std::ios::binary);
+    if (!input.is_open()) return false;
+    if (!read(input)){
+        std::cout << "Discarding unreadable cache entry " << file << "\n";
+        input.close();
+        std::filesystem::remove(file);
+        return false;
+    }
+    // most recently used
+    std::error_code error;
+    std::filesystem::last_write_time(file, std::filesystem::file_time_type::clock::now(), error);
+    return true;
+}
+
+void resultCache::store(std::uint64_t key, const std::function<void(std::ostream&)>& write){
+    std::lock_guard<std::mutex> guard(lock);
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    std::filesystem::path file = path(key);
+    std::filesystem::path temporary = file;
+    temporary += ".tmp";
+    {
+        std::ofstream output (temporary, std::ios::binary);
+        if (!output.is_open()) return;
+        write(output);
+    }
+    std::filesystem::rename(temporary, file, error);
+    evict(file);
+}
+
+void resultCache::setLimit(std::uintmax_t limit){
+    std::lock_guard<std::mutex> guard(lock);
+    maxBytes = limit;
+    evict("");
+}
+
+// drop least recently used entries until the cache fits, lock must be held
+void resultCache::evict(const std::filesystem::path& keep){
+    std::error_code error;
+    std::vector<std::pair<std::filesystem::file_time_type, std::filesystem::path>> entries;
+    std::uintmax_t total = 0;
+    for (auto& entry : std::filesystem::directory_iterator(directory, error)){
+        if (entry.path().extension() != ".run") continue;
+        total += entry.file_size(error);
+        entries.push_back({entry.last_write_time(error), entry.path()});
+    }
+    std::sort(entries.begin(), entries.end());
+    for (auto& [time, file] : entries){
+        if (total <= maxBytes) break;
+        if (file == keep) continue;
+        std::uintmax_t size = std::filesystem::file_size(file, error);
+        if (std::filesystem::remove(file, error)){
+            total -= size;
+            std::cout << "Evicted cache entry " << file << "\n";
+        }
+    }
+}
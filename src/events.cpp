@@ -0,0 +1,145 @@
+#include "sys.h"
+
+#include <iostream>
+#include <filesystem>
+#include <algorithm>
+#include <cmath>
+
+namespace{
+
+// Root of f in [0,1], where f(0) and f(1) differ in sign - Illinois variant of regula falsi
+template <typename F>
+double root(F f, double f0, double f1){
+    double a = 0, b = 1, fa = f0, fb = f1;
+    int side = 0;
+    for (int k = 0; k < 60 && b-a > 1e-12; k++){
+        double c = (a*fb - b*fa)/(fb - fa);
+        double fc = f(c);
+        if (fc == 0) return c;
+        if ((fc < 0) == (fb < 0)){ b = c; fb = fc; if (side == -1) fa /= 2; side = -1; }
+        else { a = c; fa = fc; if (side == 1) fb /= 2; side = 1; }
+    }
+    return (a*fb - b*fa)/(fb - fa);
+}
+
+// f crosses zero between the two ends of the step (a zero at the start belongs to the previous step)
+bool signChange(double f0, double f1){ return (f0 < 0 && f1 >= 0) || (f0 > 0 && f1 <= 0); }
+
+}
+
+std::string toString(eventType t){
+    switch (t){
+        case eventType::periapsis: return "periapsis";
+        case eventType::apoapsis: return "apoapsis";
+        case eventType::conjunction: return "conjunction";
+        case eventType::opposition: return "opposition";
+        case eventType::transit: return "transit";
+        case eventType::crossing: return "crossing";
+    }
+    return "";
+}
+
+///////////////////////////////////// EVENTS
+
+template <std::size_t D>
+void basicSys<D>::openEvents(){
+    if (!events.enabled()) return;
+    auto index = [&](const std::string& name){
+        if (name == "") return -1;
+        bodyId id = originalBodies.find(name);
+        if (id == registry<body>::invalid){ std::cout << "No body named " << name << " for event detection\n"; return -1; }
+        return int(originalBodies.indexOf(id));
+    };
+    centre = index(events.centre);
+    observer = index(events.observer);
+    if (events.conjunctions && observer < 0) std::cout << "Conjunctions need an observer, none will be detected\n";
+    if (events.crossings && centre < 0) std::cout << "Crossings need a centre, none will be detected\n";
+    std::filesystem::path path (events.path);
+    if (path.has_parent_path()) std::filesystem::create_directories(path.parent_path());
+    eventLog = std::make_shared<std::ofstream>(events.path);
+    if (!eventLog->is_open()) std::cout << "Could not open the event log " << events.path << "\n";
+    eventLog->precision(12);
+    *eventLog << "# time [s] | event | body | body | distance [m] or apparent separation [rad]\n";
+}
+
+template <std::size_t D>
+void basicSys<D>::detectEvents(double t, double dT){
+    int N = bodies.size();
+    // cubic Hermite interpolant of the step, s = 0 at its start and 1 at its end
+    auto position = [&](int k, double s){
+        double s2 = s*s, s3 = s2*s;
+        return (2*s3-3*s2+1)*stepPositions[k] + ((s3-2*s2+s)*dT)*stepVelocities[k]
+          + (3*s2-2*s3)*bodies[k].getPosition() + ((s3-s2)*dT)*bodies[k].getVelocity();
+    };
+    auto velocity = [&](int k, double s){
+        double s2 = s*s;
+        return ((6*s2-6*s)/dT)*stepPositions[k] + (3*s2-4*s+1)*stepVelocities[k]
+          + ((6*s-6*s2)/dT)*bodies[k].getPosition() + (3*s2-2*s)*bodies[k].getVelocity();
+    };
+    auto add = [&](double s, eventType type, int a, int b, double value){
+        pendingEvents.push_back({t+s*dT, type, a, b, value});
+    };
+    // Apsides - radial velocity changes sign
+    if (events.apsides){
+        auto apsis = [&](int i, int j){
+            auto radial = [&](double s){ return (position(j,s)-position(i,s))*(velocity(j,s)-velocity(i,s)); };
+            double f0 = radial(0), f1 = radial(1);
+            if (!signChange(f0, f1)) return;
+            double s = root(radial, f0, f1);
+            add(s, f0 < 0 ? eventType::periapsis : eventType::apoapsis, i, j, (position(j,s)-position(i,s)).size());
+        };
+        if (centre >= 0) for (int j = 0; j < N; j++){ if (j != centre) apsis(std::min(centre,j), std::max(centre,j)); }
+        else for (int i = 0; i < N; i++) for (int j = i+1; j < N; j++) apsis(i,j);
+    }
+    // Conjunctions - the in-plane cross product of the lines of sight changes sign
+    if (events.conjunctions && observer >= 0) for (int i = 0; i < N; i++) for (int j = i+1; j < N; j++){
+        if (i == observer || j == observer) continue;
+        auto alignment = [&](double s){
+            vecD a = position(i,s)-position(observer,s), b = position(j,s)-position(observer,s);
+            return a[0]*b[1]-a[1]*b[0];
+        };
+        double f0 = alignment(0), f1 = alignment(1);
+        if (!signChange(f0, f1)) continue;
+        double s = root(alignment, f0, f1);
+        vecD a = position(i,s)-position(observer,s), b = position(j,s)-position(observer,s);
+        double da = a.size(), db = b.size();
+        double separation = acos(std::clamp((a*b)/(da*db), -1., 1.));
+        if (a*b < 0){ add(s, eventType::opposition, i, j, separation); continue; }
+        // transit - the apparent discs overlap, the nearer body is listed first
+        double discs = asin(std::min(1., bodies[i].getRadius()/da)) + asin(std::min(1., bodies[j].getRadius()/db));
+        if (separation < discs) add(s, eventType::transit, da < db ? i : j, da < db ? j : i, separation);
+        else add(s, eventType::conjunction, i, j, separation);
+    }
+    // Crossings - the distances from the centre become equal
+    if (events.crossings && centre >= 0) for (int i = 0; i < N; i++) for (int j = i+1; j < N; j++){
+        if (i == centre || j == centre) continue;
+        auto order = [&](double s){
+            vecD c = position(centre,s);
+            return (position(i,s)-c).size() - (position(j,s)-c).size();
+        };
+        double f0 = order(0), f1 = order(1);
+        if (!signChange(f0, f1)) continue;
+        double s = root(order, f0, f1);
+        add(s, eventType::crossing, i, j, (position(i,s)-position(centre,s)).size());
+    }
+    if (eventLog && pendingEvents.size() >= 1024) flushEvents();
+}
+
+template <std::size_t D>
+void basicSys<D>::flushEvents(){
+    // events of one step are found pair by pair
+    std::stable_sort(pendingEvents.begin(), pendingEvents.end(), [](const event& x, const event& y){ return x.time < y.time; });
+    for (auto& e : pendingEvents){
+        eventCounts[int(e.type)]++;
+        if (eventLog) *eventLog << e.time << " " << toString(e.type) << " " << bodies[e.a].getName() << " " << bodies[e.b].getName() << " " << e.value << "\n";
+    }
+    pendingEvents.clear();
+}
+
+// Planar and inclined systems
+template void basicSys<2>::openEvents();
+template void basicSys<3>::openEvents();
+template void basicSys<2>::detectEvents(double, double);
+template void basicSys<3>::detectEvents(double, double);
+template void basicSys<2>::flushEvents();
+template void basicSys<3>::flushEvents();
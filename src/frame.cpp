@@ -99,9 +99,64 @@ frame::frame(const wxString& title, const wxPoint& pos, const wxSize& size) : wx
     period_units = new wxChoice(panel,ID_PeriodUnits,wxPoint(350,260),wxSize(100,-1),timeUnits);
     period_value->Enable(false);
     period_units->Select(1);
+    // recording
+    select_record = new wxCheckBox(panel,ID_Record,"Record Series",wxPoint(10,330));
+    select_record->SetValue(true);
+    // stop criteria
+    escape_text = new wxStaticText(panel,wxID_ANY,"Escape R. [AU]: ",wxPoint(460,255));
+    escape_value = new wxTextCtrl(panel,ID_EscapeRadius,"",wxPoint(580,250),wxSize(130,25));
+    hill_text = new wxStaticText(panel,wxID_ANY,"Hill Factor: ",wxPoint(460,285));
+    hill_value = new wxTextCtrl(panel,ID_HillFactor,"",wxPoint(580,280),wxSize(130,25));
+    drift_text = new wxStaticText(panel,wxID_ANY,"Drift Tol. E / L: ",wxPoint(460,315));
+    drift_value = new wxTextCtrl(panel,ID_EnergyDrift,"",wxPoint(580,310),wxSize(63,25));
+    momentum_drift_value = new wxTextCtrl(panel,ID_MomentumDrift,"",wxPoint(647,310),wxSize(63,25));
+    select_collisions = new wxCheckBox(panel,ID_Collisions,"Stop on Collision",wxPoint(460,340));
+    select_drift_warn = new wxCheckBox(panel,ID_DriftWarn,"Drift: Warn Only",wxPoint(600,340));
+    // close encounters
+    softening_text = new wxStaticText(panel,wxID_ANY,"Softening [km]: ",wxPoint(170,305));
+    softening_value = new wxTextCtrl(panel,ID_Softening,"",wxPoint(290,300),wxSize(160,25));
+    regularization_text = new wxStaticText(panel,wxID_ANY,"Regul. R. [AU]: ",wxPoint(170,335));
+    regularization_value = new wxTextCtrl(panel,ID_Regularization,"",wxPoint(290,330),wxSize(160,25));
+    // memory budget of the recorded series, the rest spills to disk
+    memory_text = new wxStaticText(panel,wxID_ANY,"RAM Budget [MB]: ",wxPoint(170,365));
+    memory_value = new wxTextCtrl(panel,ID_MemoryBudget,"",wxPoint(290,360),wxSize(160,25));
+    memory_estimate = new wxStaticText(panel,wxID_ANY,"",wxPoint(10,352));
+    // job queue - every run works on its own copy of the system
+    jobs = std::make_unique<scheduler>(1,
+      [this](const job& j){
+        // worker thread - hand the change over to the GUI thread
+        wxCommandEvent changed( wxEVT_COMMAND_TEXT_UPDATED, JOBS );
+        changed.SetInt( j.progress );
+        changed.SetString( j.label+": "+toString(j.state)+" ("+std::to_string(j.progress)+" %)" );
+        GetEventHandler()->QueueEvent(changed.Clone());
+      },
+      [this](job& j){
+        // ROOT plotting is not thread safe, outputs are written one job at a time
+        std::lock_guard<std::mutex> guard(outputLock);
+        std::string append = " ("+j.label+")";
+        if (j.result.isRecording()) j.result.saveData({}, append);
+        std::filesystem::create_directory("Data");
+        j.result.saveReport("Data/report"+append+".txt");
+      });
+    jobs_text = new wxStaticText(panel,wxID_ANY,"Jobs: ",wxPoint(10,372));
+    job_list = new wxListBox(panel,ID_JobList,wxPoint(10,390),wxSize(440,120),wxArrayString(),wxLB_SINGLE);
+    cancel_job_button = new wxButton(panel,ID_CancelJob,"Cancel Job",wxPoint(460,390),wxSize(250,25));
+    raise_priority_button = new wxButton(panel,ID_RaisePriority,"Raise Priority",wxPoint(460,420),wxSize(250,25));
+    lower_priority_button = new wxButton(panel,ID_LowerPriority,"Lower Priority",wxPoint(460,450),wxSize(250,25));
+    wxArrayString slotChoices;
+    for (int i = 1; i <= jobs->poolSize(); i++) slotChoices.Add(std::to_string(i));
+    slots_text = new wxStaticText(panel,wxID_ANY,"Concurrent Runs: ",wxPoint(460,487));
+    slots_choice = new wxChoice(panel,ID_Slots,wxPoint(580,480),wxSize(130,-1),slotChoices);
+    slots_choice->Select(0);
+    clear_jobs_button = new wxButton(panel,ID_ClearJobs,"Clear Finished",wxPoint(460,510),wxSize(250,25));
 
 }
 
+frame::~frame(){
+  // stop the workers while the frame can still receive their events
+  jobs.reset();
+}
+
 void frame::EnableDistance(wxCommandEvent& event){
   std::vector<std::string> pivots;
   wxArrayInt planetSelections;
@@ -183,18 +238,76 @@ void frame::OnRun(wxCommandEvent& event){
   }
   T *= timeSI(duration_units->GetSelection());
 
-  // Validate and RUN simulation
-  if (valid){
-
-    auto run = [T,dT,this](){
-      this->starSystem.solve(T,dT,this);
-      this->starSystem.saveData(this);
-    };
+  // stop criteria - empty fields disable them
+  stopCriteria criteria;
+  std::string escapeString = std::string(escape_value->GetLineText(0).mb_str());
+  if (escapeString!=""){
+    analysis << escapeString;
+    analysis >> criteria.escapeRadius;
+    analysis.clear();
+    criteria.escapeRadius *= AU;
+  }
+  std::string hillString = std::string(hill_value->GetLineText(0).mb_str());
+  if (hillString!=""){
+    analysis << hillString;
+    analysis >> criteria.hillFactor;
+    analysis.clear();
+  }
+  std::string driftString = std::string(drift_value->GetLineText(0).mb_str());
+  if (driftString!=""){
+    analysis << driftString;
+    analysis >> criteria.energyDrift;
+    analysis.clear();
+  }
+  std::string momentumDriftString = std::string(momentum_drift_value->GetLineText(0).mb_str());
+  if (momentumDriftString!=""){
+    analysis << momentumDriftString;
+    analysis >> criteria.momentumDrift;
+    analysis.clear();
+  }
+  criteria.warnOnDrift = select_drift_warn->IsChecked();
+  criteria.collisions = select_collisions->IsChecked();
+
+  // close encounters - empty fields disable them
+  double softening = 0, regularization = 0;
+  std::string softeningString = std::string(softening_value->GetLineText(0).mb_str());
+  if (softeningString!=""){
+    analysis << softeningString;
+    analysis >> softening;
+    analysis.clear();
+    softening *= 1000;
+  }
+  std::string regularizationString = std::string(regularization_value->GetLineText(0).mb_str());
+  if (regularizationString!=""){
+    analysis << regularizationString;
+    analysis >> regularization;
+    analysis.clear();
+    regularization *= AU;
+  }
 
-    std::thread indep{run};
-    indep.detach();
+  // memory budget of the recorded series - empty for no limit
+  double memoryBudget = 0;
+  std::string memoryString = std::string(memory_value->GetLineText(0).mb_str());
+  if (memoryString!=""){
+    analysis << memoryString;
+    analysis >> memoryBudget;
+    analysis.clear();
+    memoryBudget *= 1024*1024;
+  }
 
+  // Validate and RUN simulation
+  if (valid){
 
+    // queue a snapshot, later edits of the system do not affect it
+    sys snapshot = starSystem;
+    snapshot.setRecording(select_record->IsChecked());
+    snapshot.setStopCriteria(criteria);
+    snapshot.setCache(&cache);
+    snapshot.setSoftening(softening);
+    snapshot.setRegularizationRadius(regularization);
+    snapshot.setMemoryBudget(std::uintmax_t(memoryBudget));
+    updateEstimate();
+    jobs->submit(snapshot,T,dT);
 
   }else{
     wxMessageBox( "Something went wrong during the insertion of parameters. Check that the numbers are in a correct format.", "ERROR", wxOK | wxICON_INFORMATION );
@@ -202,6 +315,33 @@ void frame::OnRun(wxCommandEvent& event){
 
 }
 
+// up-front estimate of the recorded series, kept up to date as the run is set up
+void frame::updateEstimate(){
+  std::stringstream analysis;
+  double dT = 0, T = 0, memoryBudget = 0;
+  analysis << std::string(timestep_value->GetLineText(0).mb_str()) << " " << std::string(duration_value->GetLineText(0).mb_str());
+  if (!(analysis >> dT >> T) || dT <= 0 || T <= 0 || !select_record->IsChecked()){
+    memory_estimate->SetLabel("");
+    return;
+  }
+  dT *= timeSI(timestep_units->GetSelection());
+  T *= timeSI(duration_units->GetSelection());
+  analysis.clear();
+  analysis.str(std::string(memory_value->GetLineText(0).mb_str()));
+  if (analysis >> memoryBudget) memoryBudget *= 1024*1024;
+  else memoryBudget = 0;
+
+  std::uintmax_t recordSize = starSystem.recordSize(T,dT);
+  std::stringstream estimate;
+  estimate.precision(3);
+  if (recordSize > 0) estimate << "Series: " << recordSize/1048576. << " MB" << (memoryBudget > 0 && recordSize > memoryBudget ? " (spills)" : "");
+  memory_estimate->SetLabel(estimate.str());
+}
+
+void frame::EstimateMemory(wxCommandEvent& event){
+  updateEstimate();
+}
+
 void frame::DeletePlanet(wxCommandEvent& event){
   wxArrayInt planetSelections;
   select_planet->GetSelections(planetSelections);
@@ -214,6 +354,7 @@ void frame::DeletePlanet(wxCommandEvent& event){
   delete select_planet_cm;
   select_planet = new wxListBox(panel,ID_SelectPlanet,wxPoint(460,140),wxSize(250,100),bodyNames,wxLB_MULTIPLE);
   select_planet_cm = new wxListBox(panel,ID_SelectPlanetsCM,wxPoint(10,140),wxSize(150,100),bodyNames,wxLB_MULTIPLE);
+  updateEstimate();
 }
 
 
@@ -225,7 +366,7 @@ void frame::CreatePlanet(wxCommandEvent& event){
 
   // body name
   std::string planetName = std::string(name_value->GetLineText(0).mb_str());
-  for (auto& elem : starSystem.getBodies()) if (planetName==elem.getName()) valid = false;
+  if (starSystem.find(planetName) != registry<body>::invalid) valid = false;
   if (planetName == "") valid = false;
   std::cout << "PLANET NAME IS " << planetName << "\n";
 
@@ -334,6 +475,7 @@ void frame::CreatePlanet(wxCommandEvent& event){
     mass_value->ChangeValue("");
     radius_value->ChangeValue("");
     name_value->ChangeValue("");
+    updateEstimate();
 
   }else{
     wxMessageBox( "Something went wrong during the insertion of parameters. Check that the numbers are in a correct format, and that the name of the body is not repeated or an empty string.", "ERROR", wxOK | wxICON_INFORMATION );
@@ -345,75 +487,24 @@ void frame::Save(wxCommandEvent& event){
   wxFileDialog saveFileDialog(this, _("Save SYS file"), "", "", "SYS files (*.sys)|*.sys", wxFD_SAVE|wxFD_OVERWRITE_PROMPT);
   if (saveFileDialog.ShowModal() == wxID_CANCEL) return;
   std::string path = std::string(saveFileDialog.GetPath().mb_str());
-  std::cout << "Saving file " << path << "\n";
-  std::ofstream output;
-  output.open(path);
-  std::cout << "File status: " << output.is_open() << "\n";
-
-  for (int i = 0; i < starSystem.size(); i++){
-    std::cout << "saving " << starSystem[i].getName()  <<"\n";
-    output << "( NAME " << starSystem[i].getName() << " MASS " << starSystem[i].getMass()
-    << " RADIUS " << starSystem[i].getRadius() << " TEMP " << starSystem[i].getTemperature()
-    << " ANGLE " << starSystem[i].getAngle() << " ANGVEL " << starSystem[i].getAngularVelocity()
-    << " POS " << starSystem[i].getPosition().X() << " " << starSystem[i].getPosition().Y()
-    << " VEL " << starSystem[i].getVelocity().X() << " " << starSystem[i].getVelocity().Y()
-    << " ACC " << starSystem[i].getAcceleration().X() << " " << starSystem[i].getAcceleration().Y()
-    << " HEATSRC " << starSystem[i].getIsHeatSource() << " )"
-    << "\n";
-  }
-  output.close();
+  std::cout << "File status: " << starSystem.save(path) << "\n";
 }
 
 void frame::Load(wxCommandEvent& event){
 
-  starSystem = sys();
   wxFileDialog openFileDialog(this, _("Open SYS file"), "", "", "SYS files (*.sys)|*.sys", wxFD_OPEN|wxFD_FILE_MUST_EXIST);
   if (openFileDialog.ShowModal() == wxID_CANCEL) return;
   std::string path = std::string(openFileDialog.GetPath().mb_str());
-  std::cout << "Loading file " << path << "\n";
-  std::ifstream input;
-  input.open(path);
-  std::cout << "File status: " << input.is_open() << "\n";
-
-  double M, R, T, angulVel, dayAngle;
-  double x,y, vx,vy, ax,ay;
-  bool heatSource;
-  std::string name;
-  std::string in;
-
-  while (!input.eof()){
-    input >> in;
-    std::cout << in << " ";
-    if (in == "NAME"){
-      input >> name;
-    }else if(in == "MASS"){
-      input >> M;
-    }else if(in == "RADIUS"){
-      input >> R;
-    }else if(in == "TEMP"){
-      input >> T;
-    }else if(in == "ANGLE"){
-      input >> dayAngle;
-    }else if(in == "ANGVEL"){
-      input >> angulVel;
-    }else if(in == "POS"){
-      input >> x >> y;
-    }else if(in == "VEL"){
-      input >> vx >> vy;
-    }else if(in == "ACC"){
-      input >> ax >> ay;
-    }else if(in == "HEATSRC"){
-      input >> heatSource;
-    }else if(in == ")"){
-      starSystem.linkBody( body(M,R,vec2(x,y),vec2(vx,vy),vec2(ax,ay),angulVel,name,T,heatSource,dayAngle) );
-      bodyNames.Add(name);
-      in = "";
-    }
-  }
+  starSystem = sys();
+  std::cout << "File status: " << starSystem.load(path) << "\n";
+
+  bodyNames.Clear();
+  for (auto& b : starSystem.getBodies()) bodyNames.Add(b.getName());
   delete select_planet;
   delete select_planet_cm;
   select_planet = new wxListBox(panel,ID_SelectPlanet,wxPoint(460,140),wxSize(250,100),bodyNames,wxLB_MULTIPLE);
   select_planet_cm = new wxListBox(panel,ID_SelectPlanetsCM,wxPoint(10,140),wxSize(150,100),bodyNames,wxLB_MULTIPLE);
+  updateEstimate();
 }
 
 void frame::updateProgress(wxCommandEvent& event){
@@ -424,6 +515,53 @@ void frame::updateStatus(wxCommandEvent& event){
   SetStatusText( event.GetString() );
 }
 
+void frame::updateJobs(wxCommandEvent& event){
+  listJobs();
+  progress_bar->SetValue( event.GetInt() );
+  SetStatusText( event.GetString() );
+}
+
+void frame::listJobs(){
+  wxArrayString jobLabels;
+  jobIds.clear();
+  for (auto& j : jobs->list()){
+    jobIds.push_back(j.number);
+    jobLabels.Add("#"+std::to_string(j.number)+" "+j.label+" - "+toString(j.state)+" "+std::to_string(j.progress)+" % (priority "+std::to_string(j.priority)+")");
+  }
+  int selection = job_list->GetSelection();
+  job_list->Set(jobLabels);
+  if (selection != wxNOT_FOUND && selection < int(jobLabels.GetCount())) job_list->SetSelection(selection);
+}
+
+void frame::CancelJob(wxCommandEvent& event){
+  int selection = job_list->GetSelection();
+  if (selection != wxNOT_FOUND) jobs->cancel(jobIds[selection]);
+}
+
+void frame::RaisePriority(wxCommandEvent& event){
+  int selection = job_list->GetSelection();
+  if (selection == wxNOT_FOUND) return;
+  auto j = jobs->get(jobIds[selection]);
+  if (j) jobs->setPriority(j->number, j->priority+1);
+}
+
+void frame::LowerPriority(wxCommandEvent& event){
+  int selection = job_list->GetSelection();
+  if (selection == wxNOT_FOUND) return;
+  auto j = jobs->get(jobIds[selection]);
+  if (j) jobs->setPriority(j->number, j->priority-1);
+}
+
+void frame::ClearJobs(wxCommandEvent& event){
+  jobs->clearFinished();
+  job_list->SetSelection(wxNOT_FOUND);
+  listJobs();
+}
+
+void frame::ChangeSlots(wxCommandEvent& event){
+  jobs->setSlots(slots_choice->GetSelection()+1);
+}
+
 wxBEGIN_EVENT_TABLE(frame, wxFrame)
   EVT_MENU(ID_Test,    frame::OnHello)
   EVT_MENU(wxID_EXIT,  frame::OnExit)
@@ -439,4 +577,16 @@ wxBEGIN_EVENT_TABLE(frame, wxFrame)
   EVT_LISTBOX(ID_SelectPlanetsCM, frame::EnableDistance)
   EVT_COMMAND  (PROGRESS, wxEVT_COMMAND_TEXT_UPDATED, frame::updateProgress)
   EVT_COMMAND  (STATUS, wxEVT_COMMAND_TEXT_UPDATED, frame::updateStatus)
+  EVT_COMMAND  (JOBS, wxEVT_COMMAND_TEXT_UPDATED, frame::updateJobs)
+  EVT_BUTTON(ID_CancelJob, frame::CancelJob)
+  EVT_BUTTON(ID_RaisePriority, frame::RaisePriority)
+  EVT_BUTTON(ID_LowerPriority, frame::LowerPriority)
+  EVT_BUTTON(ID_ClearJobs, frame::ClearJobs)
+  EVT_CHOICE(ID_Slots, frame::ChangeSlots)
+  EVT_TEXT(ID_TimeStep, frame::EstimateMemory)
+  EVT_TEXT(ID_Duration, frame::EstimateMemory)
+  EVT_TEXT(ID_MemoryBudget, frame::EstimateMemory)
+  EVT_CHOICE(ID_TimeStepUnits, frame::EstimateMemory)
+  EVT_CHOICE(ID_DurationUnits, frame::EstimateMemory)
+  EVT_CHECKBOX(ID_Record, frame::EstimateMemory)
 wxEND_EVENT_TABLE()
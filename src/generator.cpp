@@ -0,0 +1,130 @@
+#include "generator.h"
+#include "parallel.h"
+#include "def.h"
+
+#include <cmath>
+#include <algorithm>
+
+namespace generator{
+
+namespace{
+
+// Random stream of one body - splitmix64, started from the population seed and the body index
+class stream{
+
+private:
+    std::uint64_t state;
+    static std::uint64_t mix(std::uint64_t z){
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+public:
+    stream(std::uint64_t seed, std::uint64_t index) : state(mix(seed + mix(index + 0x9E3779B97F4A7C15ull))) {}
+    std::uint64_t next(){ return mix(state += 0x9E3779B97F4A7C15ull); }
+    // uniform in [0,1) and [a,b)
+    double uniform(){ return (next() >> 11) * 0x1.0p-53; }
+    double uniform(double a, double b){ return a + (b-a)*uniform(); }
+    // standard normal (Box-Muller)
+    double normal(){ return sqrt(-2*log(1-uniform()))*cos(2*PI*uniform()); }
+
+};
+
+// Uniformly distributed direction
+template <std::size_t D>
+vec<double,D> direction(stream& rng){
+    vec<double,D> n;
+    double phi = 2*PI*rng.uniform();
+    if constexpr (D >= 3){
+        double z = rng.uniform(-1,1), s = sqrt(1-z*z);
+        n[0] = s*cos(phi); n[1] = s*sin(phi); n[2] = z;
+    }else{
+        n[0] = cos(phi); n[1] = sin(phi);
+    }
+    return n;
+}
+
+// Distance to the pivots of a disk or ring body
+double orbitRadius(const population& p, stream& rng){
+    double a = p.innerRadius, b = p.outerRadius;
+    if (p.kind == shape::ring){
+        double mean = (a+b)/2, sigma = (b-a)/6;
+        if (sigma <= 0) return mean;
+        double r;
+        do r = mean + sigma*rng.normal(); while (r < a || r > b);
+        return r;
+    }
+    // inverse of the cumulative distribution of r^(1-densityIndex)
+    double k = 2-p.densityIndex, u = rng.uniform();
+    if (std::abs(k) < 1e-12) return a*pow(b/a, u);
+    return pow(pow(a,k) + u*(pow(b,k)-pow(a,k)), 1/k);
+}
+
+template <std::size_t D>
+basicBody<D> make(const population& p, const origin<D>& o, std::size_t index, double clusterMass){
+    using vecD = vec<double,D>;
+    stream rng (p.seed, index);
+    // body
+    double mass = p.minMass > 0 && p.maxMass > p.minMass ? p.minMass*pow(p.maxMass/p.minMass, rng.uniform()) : std::max(p.minMass, p.maxMass);
+    double radius = p.density > 0 ? cbrt(3*mass/(4*PI*p.density)) : 0;
+    vecD pos = o.position, vel = o.velocity;
+    if (p.kind == shape::cluster){
+        // Plummer sphere - radius from the inverted mass profile, speed by rejection from the distribution function
+        double a = p.outerRadius, r;
+        do r = a/sqrt(pow(rng.uniform(), -2./3)-1); while (r > 10*a);
+        double q, y;
+        do { q = rng.uniform(); y = 0.1*rng.uniform(); } while (y > q*q*pow(1-q*q, 3.5));
+        double escape = sqrt(2*G*clusterMass/a)*pow(1+r*r/(a*a), -0.25);
+        pos = pos + r*direction<D>(rng);
+        vel = vel + q*escape*direction<D>(rng);
+    }else{
+        // Keplerian orbit around the pivots, placed at a random true anomaly
+        double r = orbitRadius(p, rng);
+        double theta = 2*PI*rng.uniform();
+        double e = p.maxEccentricity*rng.uniform();
+        double f = 2*PI*rng.uniform();
+        double inclination = p.maxInclination*rng.uniform(-1,1), node = 2*PI*rng.uniform();
+        double mu = G*(o.mass+mass), semiLatus = r*(1+e*cos(f));
+        double vr = 0, vt = 0;
+        if (mu > 0 && semiLatus > 0){ vr = sqrt(mu/semiLatus)*e*sin(f); vt = sqrt(mu/semiLatus)*(1+e*cos(f)); }
+        if (p.inverted) vt = -vt;
+        // in-plane directions, tilted about the x axis by the inclination and turned about z to the node (3D only)
+        vecD radial, tangent;
+        radial[0] = cos(theta); tangent[0] = -sin(theta);
+        radial[1] = sin(theta); tangent[1] = cos(theta);
+        if constexpr (D >= 3){
+            for (vecD* v : {&radial, &tangent}){
+                vecD& u = *v;
+                u[2] = u[1]*sin(inclination); u[1] *= cos(inclination);
+                double x = u[0], y = u[1];
+                u[0] = x*cos(node) - y*sin(node); u[1] = x*sin(node) + y*cos(node);
+            }
+        }
+        pos = pos + r*radial;
+        vel = vel + vr*radial + vt*tangent;
+    }
+    return basicBody<D>(mass, radius, pos, vel, vecD(), 0, p.prefix+std::to_string(index), p.temperature, false, 0);
+}
+
+}
+
+template <std::size_t D>
+std::vector<basicBody<D>> generate(const population& p, const origin<D>& o, std::size_t first, std::size_t last){
+    last = std::min(last, p.count);
+    std::vector<basicBody<D>> bodies (last > first ? last-first : 0);
+    // cluster potential - the pivots plus the expected mass of the whole population
+    double meanMass = p.minMass > 0 && p.maxMass > p.minMass ? (p.maxMass-p.minMass)/log(p.maxMass/p.minMass) : std::max(p.minMass, p.maxMass);
+    double clusterMass = o.mass + p.count*meanMass;
+    const std::size_t chunk = 1024;
+    parallel::forEach((bodies.size()+chunk-1)/chunk, [&](std::size_t c){
+        for (std::size_t i = c*chunk; i < std::min(bodies.size(), (c+1)*chunk); i++) bodies[i] = make<D>(p, o, first+i, clusterMass);
+    });
+    return bodies;
+}
+
+// Planar and inclined systems
+template std::vector<basicBody<2>> generate(const population&, const origin<2>&, std::size_t, std::size_t);
+template std::vector<basicBody<3>> generate(const population&, const origin<3>&, std::size_t, std::size_t);
+
+}
@@ -0,0 +1,41 @@
+#include "output.h"
+
+#include <dlfcn.h>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <filesystem>
+
+outputBackend* loadOutputBackend(){
+    static std::mutex lock;
+    static std::unique_ptr<outputBackend> backend;
+    static bool attempted = false;
+
+    std::lock_guard<std::mutex> guard(lock);
+    if (attempted) return backend.get();
+    attempted = true;
+
+    std::vector<std::string> candidates;
+    if (const char* env = std::getenv("STABLE_PLANETS_OUTPUT_PLUGIN")) candidates.push_back(env);
+    std::error_code error;
+    std::filesystem::path exe = std::filesystem::read_symlink("/proc/self/exe", error);
+    if (!error) candidates.push_back((exe.parent_path() / "plugins" / "libroot_output.so").string());
+    candidates.push_back("libroot_output.so");
+
+    for (auto& path : candidates){
+        // never closed - plotting libraries do not support being unloaded
+        void* handle = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+        if (!handle) continue;
+        auto create = reinterpret_cast<createOutputBackendFunction>(dlsym(handle, OUTPUT_BACKEND_ENTRY));
+        if (!create){
+            std::cout << path << " is not an output plugin\n";
+            continue;
+        }
+        backend.reset(create());
+        std::cout << "Loaded output plugin " << path << "\n";
+        return backend.get();
+    }
+    std::cout << "No output plugin could be loaded: " << dlerror() << "\n";
+    return nullptr;
+}
@@ -0,0 +1,80 @@
+#include "parallel.h"
+
+#include <thread>
+#include <atomic>
+#include <algorithm>
+
+#ifdef STABLE_PLANETS_MPI
+#include <mpi.h>
+#endif
+
+namespace parallel{
+
+#ifdef STABLE_PLANETS_MPI
+
+void init(int* argc, char*** argv){
+    int initialized;
+    MPI_Initialized(&initialized);
+    if (!initialized) MPI_Init(argc, argv);
+}
+
+void finalize(){
+    int finalized;
+    MPI_Finalized(&finalized);
+    if (!finalized) MPI_Finalize();
+}
+
+int rank(){
+    int initialized, r = 0;
+    MPI_Initialized(&initialized);
+    if (initialized) MPI_Comm_rank(MPI_COMM_WORLD, &r);
+    return r;
+}
+
+int ranks(){
+    int initialized, n = 1;
+    MPI_Initialized(&initialized);
+    if (initialized) MPI_Comm_size(MPI_COMM_WORLD, &n);
+    return n;
+}
+
+void allgather(const std::vector<double>& local, std::vector<double>& global, std::size_t n, std::size_t stride){
+    int size = ranks();
+    std::vector<int> counts (size), offsets (size);
+    for (int r = 0; r < size; r++){
+        auto [first, last] = block(n, r);
+        counts[r] = (last-first)*stride;
+        offsets[r] = first*stride;
+    }
+    global.resize(n*stride);
+    MPI_Allgatherv(local.data(), local.size(), MPI_DOUBLE, global.data(), counts.data(), offsets.data(), MPI_DOUBLE, MPI_COMM_WORLD);
+}
+
+#else
+
+void init(int*, char***) {}
+void finalize() {}
+int rank() { return 0; }
+int ranks() { return 1; }
+void allgather(const std::vector<double>& local, std::vector<double>& global, std::size_t, std::size_t) { global = local; }
+
+#endif
+
+std::pair<std::size_t,std::size_t> block(std::size_t n, int r){
+    std::size_t size = ranks();
+    std::size_t first = n*r/size;
+    std::size_t last = n*(r+1)/size;
+    return {first, last};
+}
+
+void forEach(std::size_t count, const std::function<void(std::size_t)>& fn, int threads){
+    if (threads <= 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    std::atomic<std::size_t> next {0};
+    auto work = [&]{ for (std::size_t k = next++; k < count; k = next++) fn(k); };
+    std::vector<std::thread> pool;
+    for (std::size_t k = 1; k < std::min<std::size_t>(threads, count); k++) pool.emplace_back(work);
+    work();
+    for (auto& t : pool) t.join();
+}
+
+}
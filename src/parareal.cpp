@@ -0,0 +1,197 @@
+#include "sys.h"
+#include "parallel.h"
+
+#include <iostream>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+
+///////////////////////////////////// PARAREAL
+
+template <std::size_t D>
+void basicSys<D>::append(basicSys& slice){
+    // the slice directly follows this run
+    recorded.append(slice.recorded);
+    energyDriftStats.merge(slice.energyDriftStats);
+    momentumDriftStats.merge(slice.momentumDriftStats);
+    energy = slice.energy; momentum = slice.momentum;
+    if (driftWarning == "") driftWarning = slice.driftWarning;
+    for (int i = 0; i < bodies.size(); i++){
+        temperatureStats[i].merge(slice.temperatureStats[i]);
+        speedStats[i].merge(slice.speedStats[i]);
+        for (int j = i+1; j < bodies.size(); j++) orbitStats[i][j].merge(slice.orbitStats[i][j]);
+    }
+    bodies = slice.bodies;
+    pendingEvents.insert(pendingEvents.end(), slice.pendingEvents.begin(), slice.pendingEvents.end());
+    keyframeSteps.insert(keyframeSteps.end(), slice.keyframeSteps.begin(), slice.keyframeSteps.end());
+    keyframes.insert(keyframes.end(), slice.keyframes.begin(), slice.keyframes.end());
+    previousSpeed = slice.previousSpeed;
+    clock = slice.clock; steps = slice.steps;
+    stopped = slice.stopped; stopMessage = slice.stopMessage; stopTime = slice.stopTime;
+    slice = basicSys<D>();
+}
+
+template <std::size_t D>
+void basicSys<D>::solveParareal(double T, double dT, progressCallback progress){
+
+    auto report = [&](int percent, const std::string& msg){
+      if (progress) progress(percent, msg);
+    };
+    auto clockStart = std::chrono::steady_clock::now();
+    reset();
+    long totalSteps = stepsUntil(0, T, dT);
+    allocate(totalSteps);
+    previousSpeed.assign(bodies.size(), 0);
+    openEvents();
+
+    // time slices - slice k covers the steps [first[k], first[k+1])
+    int threads = std::max(1u, std::thread::hardware_concurrency());
+    int N = std::max<long>(1, std::min<long>(parareal.slices > 0 ? parareal.slices : threads, totalSteps));
+    int maxIterations = parareal.maxIterations > 0 ? std::min(parareal.maxIterations, N) : N;
+    std::vector<long> first (N+1);
+    for (int k = 0; k <= N; k++) first[k] = totalSteps*k/N;
+    // slice start times - accumulated like the serial loop, so every step runs at the same t
+    std::vector<double> times (N+1);
+    double elapsed = 0;
+    for (long k = 0, n = 0; k <= N; k++){
+        for (; n < first[k]; n++) elapsed += dT;
+        times[k] = elapsed;
+    }
+    pararealResult.slices = N;
+    std::cout << "|| Solving system with Parareal ...\n";
+    std::cout << N << " time slices on " << std::min(threads, N) << " threads, coarse step of " << parareal.coarseFactor << " time steps\n";
+
+    // coarse propagator - the same integrator with a longer step
+    auto coarse = [&](const std::vector<body>& start, int k){
+        long n = first[k+1]-first[k];
+        long m = std::max(1L, n/std::max(1, parareal.coarseFactor));
+        return propagate(start, m, (times[k+1]-times[k])/m);
+    };
+    // corrected start state - new coarse + (fine - old coarse) for positions and velocities, the rest from the fine run
+    auto correct = [](const std::vector<body>& g, const std::vector<body>& f, const std::vector<body>& gOld){
+        std::vector<body> state (f.size());
+        for (int i = 0; i < f.size(); i++){
+            vecD pos = g[i].getPosition() + (f[i].getPosition() - gOld[i].getPosition());
+            vecD vel = g[i].getVelocity() + (f[i].getVelocity() - gOld[i].getVelocity());
+            state[i] = body(f[i].getMass(),f[i].getRadius(),pos,vel,f[i].getAcceleration(),f[i].getAngularVelocity(),f[i].getName(),f[i].getTemperature(),f[i].getIsHeatSource(),f[i].getAngle());
+        }
+        return state;
+    };
+    // change between two states, relative to the size and speed spread of the initial system
+    double lengthScale = 0, speedScale = 0;
+    for (int i = 0; i < bodies.size(); i++) for (int j = i+1; j < bodies.size(); j++){
+        lengthScale = std::max(lengthScale, (bodies[j].getPosition()-bodies[i].getPosition()).size());
+        speedScale = std::max(speedScale, (bodies[j].getVelocity()-bodies[i].getVelocity()).size());
+    }
+    if (lengthScale == 0) lengthScale = 1;
+    if (speedScale == 0) speedScale = 1;
+    auto change = [&](const std::vector<body>& a, const std::vector<body>& b){
+        double c = 0;
+        for (int i = 0; i < a.size(); i++){
+            c = std::max(c, (a[i].getPosition()-b[i].getPosition()).size()/lengthScale);
+            c = std::max(c, (a[i].getVelocity()-b[i].getVelocity()).size()/speedScale);
+        }
+        return c;
+    };
+
+    // initial prediction - coarse run through all slices
+    std::vector<std::vector<body>> starts (N+1), predicted (N);
+    starts[0] = bodies;
+    for (int k = 0; k < N; k++){
+        predicted[k] = coarse(starts[k], k);
+        starts[k+1] = predicted[k];
+    }
+
+    // fine runs of the slices, with data extraction and stop checks - the last run of each slice is kept
+    std::vector<basicSys<D>> slices (N);
+    auto fine = [&](int k){
+        basicSys<D>& s = slices[k];
+        s = basicSys<D>();
+        s.softening = softening; s.regularizationRadius = regularizationRadius;
+        s.recording = recording; s.criteria = criteria; s.cancelToken = cancelToken;
+        s.initialEnergy = initialEnergy; s.initialMomentum = initialMomentum; s.momentumScale = momentumScale;
+        s.events = events; s.centre = centre; s.observer = observer;
+        s.keyframeInterval = keyframeInterval;
+        // the slices share the memory budget
+        s.memoryBudget = memoryBudget > 0 ? std::max<std::uintmax_t>(1, memoryBudget/N) : 0; s.spillDirectory = spillDirectory;
+        s.bodies = starts[k];
+        s.allocate(first[k+1]-first[k]);
+        for (auto& b : s.bodies) s.previousSpeed.push_back(b.getVelocity().size());
+        s.steps = first[k];
+        double t = times[k];
+        for (long n = first[k]; n < first[k+1]; n++, t += dT) if (!s.step(t, dT, true)) break;
+        s.closeSample();
+    };
+
+    // slices before `settled` start from the exact state, their fine runs are final
+    int settled = 0;
+    for (int iteration = 0; iteration < maxIterations; iteration++){
+        report(100*iteration/maxIterations, "Parareal iteration "+std::to_string(iteration+1)+"...");
+        parallel::forEach(N-settled, [&](std::size_t n){ fine(settled+n); }, threads);
+        pararealResult.iterations++;
+        // first slice that stopped early - final only if it started from the exact state
+        int stop = N;
+        for (int k = 0; k < N; k++) if (slices[k].stopped != stopReason::none){ stop = k; break; }
+        if (stop < N && (stop <= settled || slices[stop].stopped == stopReason::cancelled)){
+            pararealResult.converged = slices[stop].stopped != stopReason::cancelled;
+            break;
+        }
+        // correction sweep - serial, with the coarse propagator
+        double c = 0;
+        std::vector<std::vector<body>> next = starts;
+        next[settled+1] = slices[settled].bodies;
+        c = std::max(c, change(next[settled+1], starts[settled+1]));
+        for (int k = settled+1; k < N; k++){
+            std::vector<body> g = coarse(next[k], k);
+            next[k+1] = correct(g, slices[k].bodies, predicted[k]);
+            predicted[k] = std::move(g);
+            c = std::max(c, change(next[k+1], starts[k+1]));
+        }
+        starts = std::move(next);
+        settled++;
+        pararealResult.corrections.push_back(c);
+        std::cout << "Iteration " << iteration+1 << ": correction " << c << "\n";
+        if (settled == N || (stop == N && c < parareal.tolerance)){
+            pararealResult.converged = true;
+            break;
+        }
+    }
+    if (!pararealResult.converged) std::cout << "Parareal did not converge\n";
+
+    // join the slices up to the first one that stopped
+    for (int k = 0; k < N && stopped == stopReason::none; k++){
+        append(slices[k]);
+        flushEvents();
+    }
+    eventLog.reset();
+    duration = stopped == stopReason::none ? T : stopTime;
+    pararealResult.wallTime = std::chrono::duration<double>(std::chrono::steady_clock::now()-clockStart).count();
+    if (stopped != stopReason::none) std::cout << "Stopped at t = " << stopTime << " s: " << stopMessage << "\n";
+
+    // serial reference run with the same settings
+    if (parareal.reference && stopped != stopReason::cancelled){
+        std::cout << "|| Serial reference run ...\n";
+        report(100, "Serial reference run...");
+        basicSys<D> reference;
+        for (auto& b : originalBodies.data()) reference.linkBody(b);
+        reference.softening = softening; reference.regularizationRadius = regularizationRadius;
+        reference.recording = recording; reference.criteria = criteria; reference.cancelToken = cancelToken;
+        reference.memoryBudget = memoryBudget; reference.spillDirectory = spillDirectory;
+        auto referenceStart = std::chrono::steady_clock::now();
+        reference.solve(T, dT);
+        pararealResult.referenceTime = std::chrono::duration<double>(std::chrono::steady_clock::now()-referenceStart).count();
+        for (int i = 0; i < bodies.size(); i++)
+            pararealResult.deviation = std::max(pararealResult.deviation, (bodies[i].getPosition()-reference.bodies[i].getPosition()).size());
+        std::cout << "Speedup " << pararealResult.referenceTime/pararealResult.wallTime << ", final deviation " << pararealResult.deviation << " m\n";
+    }
+
+    report(0, stopped == stopReason::none ? "Done!" : "Stopped early: "+stopMessage);
+
+    // DONE
+    std::cout << "Done!\n";
+}
+
+// Planar and inclined systems
+template void basicSys<2>::solveParareal(double, double, progressCallback);
+template void basicSys<3>::solveParareal(double, double, progressCallback);
@@ -0,0 +1,152 @@
+#include "scheduler.h"
+
+#include <algorithm>
+
+scheduler::scheduler(int s, listener change, finisher finish)
+: slots(std::max(s,1)), onChange(change), onFinish(finish)
+{
+    int pool = std::max<int>(std::thread::hardware_concurrency(), slots);
+    for (int i = 0; i < pool; i++) workers.emplace_back(&scheduler::work, this);
+}
+
+scheduler::~scheduler(){
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+        for (auto& j : jobs) j->cancelled = true;
+    }
+    wake.notify_all();
+    for (auto& w : workers) w.join();
+}
+
+job::id scheduler::submit(const sys& s, double T, double dT, int priority, std::string label){
+    std::shared_ptr<job> j;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        job::id n = nextId++;
+        if (label == "") label = "Run "+std::to_string(n);
+        j = std::make_shared<job>(n, label, s, T, dT, priority);
+        jobs.push_back(j);
+    }
+    if (onChange) onChange(*j);
+    wake.notify_one();
+    return j->number;
+}
+
+bool scheduler::cancel(job::id n){
+    std::shared_ptr<job> j;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        for (auto& elem : jobs) if (elem->number == n) j = elem;
+        if (!j || j->state == jobState::done || j->state == jobState::cancelled) return false;
+        j->cancelled = true;
+        // queued jobs are cancelled right away, running ones stop at their next step
+        if (j->state == jobState::queued) j->state = jobState::cancelled;
+    }
+    if (onChange) onChange(*j);
+    return true;
+}
+
+bool scheduler::setPriority(job::id n, int priority){
+    std::shared_ptr<job> j;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        for (auto& elem : jobs) if (elem->number == n) j = elem;
+        if (!j) return false;
+        j->priority = priority;
+    }
+    if (onChange) onChange(*j);
+    return true;
+}
+
+std::shared_ptr<const job> scheduler::get(job::id n) const {
+    std::lock_guard<std::mutex> guard(lock);
+    for (auto& j : jobs) if (j->number == n) return j;
+    return nullptr;
+}
+
+std::size_t scheduler::clearFinished(){
+    std::size_t removed;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        std::size_t before = jobs.size();
+        std::erase_if(jobs, [](const std::shared_ptr<job>& j){ return j->state == jobState::done || j->state == jobState::cancelled; });
+        removed = before - jobs.size();
+    }
+    return removed;
+}
+
+std::vector<jobInfo> scheduler::list() const {
+    std::lock_guard<std::mutex> guard(lock);
+    std::vector<jobInfo> info;
+    for (auto& j : jobs) info.push_back({j->number, j->label, j->priority, j->progress, j->state});
+    return info;
+}
+
+void scheduler::setSlots(int s){
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        slots = std::clamp<int>(s, 1, workers.size());
+    }
+    wake.notify_all();
+}
+
+int scheduler::getSlots() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return slots;
+}
+
+// highest priority queued job, lock must be held
+std::shared_ptr<job> scheduler::next(){
+    std::shared_ptr<job> best;
+    for (auto& j : jobs) if (j->state == jobState::queued && (!best || j->priority > best->priority)) best = j;
+    return best;
+}
+
+void scheduler::work(){
+    while (true){
+        std::shared_ptr<job> j;
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            wake.wait(guard, [this]{ return stopping || (running < slots && next()); });
+            if (stopping) return;
+            j = next();
+            j->state = jobState::running;
+            running++;
+        }
+        if (onChange) onChange(*j);
+
+        // solve a private copy of the snapshot
+        j->result = j->snapshot;
+        j->result.setCancelToken(&j->cancelled);
+        j->result.solve(j->duration, j->timeStep, [this, j](int value, const std::string&){
+            if (value != j->progress){
+                j->progress = value;
+                if (onChange) onChange(*j);
+            }
+        });
+        j->result.setCancelToken(nullptr);
+        if (!j->cancelled && onFinish) onFinish(*j);
+        // the output is written, the recorded data is not needed any more
+        j->result = sys();
+        j->progress = 100;
+
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            j->state = j->cancelled ? jobState::cancelled : jobState::done;
+            running--;
+        }
+        wake.notify_all();
+        if (onChange) onChange(*j);
+    }
+}
+
+std::string toString(jobState s){
+    switch(s){
+        case jobState::queued: return "queued";
+        case jobState::running: return "running";
+        case jobState::done: return "done";
+        case jobState::cancelled: return "cancelled";
+        default: return "";
+    }
+}
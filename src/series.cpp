@@ -0,0 +1,210 @@
+#include "series.h"
+#include "binary.h"
+
+#include <zlib.h>
+#include <unistd.h>
+#include <fstream>
+#include <filesystem>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <limits>
+
+// Spill file - append-only heap of compressed chunks, removed once no store refers to it
+class seriesStore::spillFile{
+private:
+    std::filesystem::path path;
+    std::fstream file;
+    std::uint64_t end = 0;
+    std::mutex lock;
+public:
+    explicit spillFile(const std::string& dir){
+        static std::atomic<unsigned> counter {0};
+        std::error_code error;
+        std::filesystem::path base = dir != "" ? std::filesystem::path(dir) : std::filesystem::temp_directory_path(error);
+        std::filesystem::create_directories(base, error);
+        path = base / ("stable-planets-"+std::to_string(::getpid())+"-"+std::to_string(counter++)+".spill");
+        file.open(path, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+    }
+    ~spillFile(){
+        file.close();
+        std::error_code error;
+        std::filesystem::remove(path, error);
+    }
+    bool good() const {return file.is_open();}
+    std::string name() const {return path.string();}
+    // offset of the data, false when it could not be written
+    bool write(const std::vector<unsigned char>& data, std::uint64_t& offset){
+        std::lock_guard<std::mutex> guard(lock);
+        file.seekp(end);
+        if (!file.write(reinterpret_cast<const char*>(data.data()), data.size())){ file.clear(); return false; }
+        offset = end;
+        end += data.size();
+        return true;
+    }
+    bool read(std::uint64_t offset, std::vector<unsigned char>& data){
+        std::lock_guard<std::mutex> guard(lock);
+        file.seekg(offset);
+        if (!file.read(reinterpret_cast<char*>(data.data()), data.size())){ file.clear(); return false; }
+        return true;
+    }
+};
+
+namespace{
+
+// Values are compressed byte plane by byte plane - sign and exponent bytes of a smooth series barely change
+std::vector<unsigned char> pack(const double* values, std::size_t n){
+    std::vector<unsigned char> planes (n*sizeof(double));
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(values);
+    for (std::size_t k = 0; k < n; k++) for (std::size_t b = 0; b < sizeof(double); b++) planes[b*n+k] = bytes[k*sizeof(double)+b];
+    uLongf size = compressBound(planes.size());
+    std::vector<unsigned char> packed (size);
+    if (compress2(packed.data(), &size, planes.data(), planes.size(), Z_BEST_SPEED) != Z_OK) return {};
+    packed.resize(size);
+    return packed;
+}
+
+bool unpack(const std::vector<unsigned char>& packed, std::size_t n, std::vector<double>& out){
+    std::vector<unsigned char> planes (n*sizeof(double));
+    uLongf size = planes.size();
+    if (uncompress(planes.data(), &size, packed.data(), packed.size()) != Z_OK || size != planes.size()) return false;
+    std::size_t first = out.size();
+    out.resize(first+n);
+    unsigned char* bytes = reinterpret_cast<unsigned char*>(out.data()+first);
+    for (std::size_t k = 0; k < n; k++) for (std::size_t b = 0; b < sizeof(double); b++) bytes[k*sizeof(double)+b] = planes[b*n+k];
+    return true;
+}
+
+}
+
+void seriesStore::open(std::size_t series, std::uintmax_t limit, const std::string& spillDirectory){
+    count = series; samples = 0;
+    budget = limit; directory = spillDirectory;
+    memory.assign(count, {});
+    segments.clear();
+    file.reset();
+}
+
+// samples held in memory before they are spilled
+std::size_t seriesStore::segmentLength() const {
+    if (budget == 0 || count == 0) return std::numeric_limits<std::size_t>::max();
+    return std::max<std::uintmax_t>(1, budget/bytes(count, 1));
+}
+
+void seriesStore::reserve(std::size_t total){
+    bool fits = !isSpilled() && (budget == 0 || bytes(count, total) <= budget);
+    std::size_t length = fits ? total : std::min(total, segmentLength());
+    for (auto& m : memory) m.reserve(length);
+}
+
+void seriesStore::push(const std::vector<double>& sample){
+    for (std::size_t s = 0; s < count; s++) memory[s].push_back(sample[s]);
+    samples++;
+    if (held() >= segmentLength()) spill();
+}
+
+void seriesStore::spill(){
+    if (!file){
+        file = std::make_shared<spillFile>(directory);
+        if (!file->good()){
+            std::cout << "Could not open a spill file in " << (directory != "" ? directory : "the temporary directory") << ", recorded series stay in memory\n";
+            file.reset();
+            budget = 0;
+            return;
+        }
+        std::cout << "Recorded series exceed the memory budget, spilling to " << file->name() << "\n";
+    }
+    segment next {held(), std::vector<chunk> (count)};
+    for (std::size_t s = 0; s < count; s++){
+        std::vector<unsigned char> packed = pack(memory[s].data(), memory[s].size());
+        next.chunks[s].size = packed.size();
+        if (packed.empty() || !file->write(packed, next.chunks[s].offset)){
+            // the segment is dropped, its samples stay in memory
+            std::cout << "Could not write to the spill file, recorded series stay in memory\n";
+            budget = 0;
+            return;
+        }
+    }
+    segments.push_back(std::move(next));
+    for (auto& m : memory) m.clear();
+}
+
+bool seriesStore::readSegment(const segment& seg, std::size_t s, std::vector<double>& out) const {
+    std::vector<unsigned char> packed (seg.chunks[s].size);
+    return file && file->read(seg.chunks[s].offset, packed) && unpack(packed, seg.samples, out);
+}
+
+std::vector<double> seriesStore::get(std::size_t s) const {
+    std::vector<double> out;
+    out.reserve(samples);
+    for (auto& seg : segments){
+        if (!readSegment(seg, s, out)){
+            std::cout << "Could not read a recorded series back from the spill file\n";
+            out.resize(out.size()+seg.samples, 0);
+        }
+    }
+    out.insert(out.end(), memory[s].begin(), memory[s].end());
+    return out;
+}
+
+void seriesStore::append(const seriesStore& other){
+    // one segment of the other store in memory at a time
+    std::vector<double> values;
+    for (auto& seg : other.segments){
+        for (std::size_t s = 0; s < count; s++){
+            values.clear();
+            if (!other.readSegment(seg, s, values)) values.assign(seg.samples, 0);
+            memory[s].insert(memory[s].end(), values.begin(), values.end());
+        }
+        samples += seg.samples;
+        if (held() >= segmentLength()) spill();
+    }
+    for (std::size_t s = 0; s < count; s++) memory[s].insert(memory[s].end(), other.memory[s].begin(), other.memory[s].end());
+    samples += other.held();
+    if (held() >= segmentLength()) spill();
+}
+
+std::uintmax_t seriesStore::memoryUsage() const {
+    std::uintmax_t total = 0;
+    for (auto& m : memory) total += m.capacity()*sizeof(double);
+    return total;
+}
+
+std::uintmax_t seriesStore::diskUsage() const {
+    std::uintmax_t total = 0;
+    for (auto& seg : segments) for (auto& c : seg.chunks) total += c.size;
+    return total;
+}
+
+void seriesStore::write(std::ostream& out) const {
+    binary::write(out, std::uint64_t(count));
+    binary::write(out, std::uint64_t(samples));
+    for (std::size_t s = 0; s < count; s++) binary::write(out, get(s));
+}
+
+bool seriesStore::read(std::istream& in){
+    std::uint64_t series, length;
+    if (!binary::read(in, series) || !binary::read(in, length)) return false;
+    open(series, budget, directory);
+    // series longer than the budget are cut into segments as they are read
+    std::size_t segmentSize = std::min<std::uintmax_t>(length, segmentLength());
+    bool spilling = budget > 0 && bytes(count, length) > budget;
+    if (spilling){
+        for (std::size_t first = 0; first < length; first += segmentSize)
+            segments.push_back({std::min<std::size_t>(segmentSize, length-first), std::vector<chunk> (count)});
+        file = std::make_shared<spillFile>(directory);
+        if (!file->good()){ file.reset(); segments.clear(); spilling = false; budget = 0; }
+    }
+    std::vector<double> values;
+    for (std::size_t s = 0; s < count; s++){
+        if (!binary::read(in, values) || values.size() != length) return false;
+        if (!spilling){ memory[s] = std::move(values); continue; }
+        for (std::size_t k = 0; k < segments.size(); k++){
+            std::vector<unsigned char> packed = pack(values.data()+k*segmentSize, segments[k].samples);
+            segments[k].chunks[s].size = packed.size();
+            if (packed.empty() || !file->write(packed, segments[k].chunks[s].offset)) return false;
+        }
+    }
+    samples = length;
+    return true;
+}
@@ -0,0 +1,55 @@
+#include "stats.h"
+
+void orbitStat::extremum(double before, double x, double after, double t){
+    if (x < before && x <= after){
+        if (periapses.getCount() == 0) firstPeriapsisTime = t;
+        lastPeriapsisTime = t;
+        periapses.push(x);
+    }else if (x > before && x >= after){
+        apoapses.push(x);
+    }
+}
+
+void orbitStat::push(double t, double d){
+    distance.push(d);
+    if (samples == 0){ first = d; firstTime = t; }
+    else if (samples == 1) second = d;
+    if (samples >= 2) extremum(beforePrevious, previous, d, previousTime);
+    beforePrevious = previous;
+    previous = d;
+    previousTime = t;
+    samples++;
+}
+
+void orbitStat::merge(const orbitStat& o){
+    if (o.samples == 0) return;
+    if (samples == 0){ *this = o; return; }
+    // the samples on either side of the seam could not be classified by their own half
+    if (samples >= 2) extremum(beforePrevious, previous, o.first, previousTime);
+    if (o.samples >= 2) extremum(previous, o.first, o.second, o.firstTime);
+    if (o.periapses.getCount() > 0){
+        if (periapses.getCount() == 0) firstPeriapsisTime = o.firstPeriapsisTime;
+        lastPeriapsisTime = o.lastPeriapsisTime;
+    }
+    distance.merge(o.distance);
+    periapses.merge(o.periapses);
+    apoapses.merge(o.apoapses);
+    if (samples == 1) second = o.first;
+    beforePrevious = o.samples >= 2 ? o.beforePrevious : previous;
+    previous = o.previous;
+    previousTime = o.previousTime;
+    samples += o.samples;
+}
+
+double orbitStat::getPeriod() const {
+    if (getOrbits() == 0) return 0;
+    return (lastPeriapsisTime-firstPeriapsisTime)/getOrbits();
+}
+
+double orbitStat::getEccentricity() const {
+    // orbit-averaged extrema when available, global extrema otherwise
+    double rp = periapses.getCount() > 0 ? periapses.getMean() : distance.getMin();
+    double ra = apoapses.getCount() > 0 ? apoapses.getMean() : distance.getMax();
+    if (distance.getCount() == 0 || ra+rp <= 0) return 0;
+    return (ra-rp)/(ra+rp);
+}
@@ -1,189 +1,889 @@
 #include "sys.h"
-#include "frame.h"
-#include "app.h"
+#include "parallel.h"
+#include "binary.h"
+#include "output.h"
+#include "kepler.h"
+#include "def.h"
+
+#include <iostream>
+#include <sstream>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
 
 ///////////////////////////////////// SOLVE
 
-void sys::deleteBody(std::string name){
-  std::vector<body> newBodies;
-  for (int i = 0; i < originalBodies.size(); i++){
-    if (originalBodies[i].getName() != name){
-      newBodies.push_back(originalBodies[i]);
-    }
-  }
-  originalBodies = newBodies;
+template <std::size_t D>
+void basicSys<D>::deleteBody(const std::string& name){
+  originalBodies.erase(name);
 }
 
-void sys::linkBody (body b){
-  std::cout << "Linked body " << b.getName() << "\n";
-  originalBodies.push_back(b);
+template <std::size_t D>
+void basicSys<D>::deleteBody(bodyId id){
+  originalBodies.erase(id);
 }
 
-void sys::linkBody(double mass, double radius, double distance, std::vector<std::string> pivots,
-  double angularVelocity, std::string name, double temperature, bool heatSource, double orbitalAngle, bool inverted, double dayAngle){
-    // Find center of mass quantities
-    vec2 centerOfMassPos(0,0);
-    vec2 centerOfMassVel(0,0);
-    double massSum = 0;
-    for (auto& a : originalBodies ) for (auto& b : pivots) if (a.getName() == b) {
-      centerOfMassPos = centerOfMassPos + a.getPosition()*a.getMass();
-      centerOfMassVel = centerOfMassVel + a.getVelocity()*a.getMass();
-      massSum += a.getMass();
+template <std::size_t D>
+generator::origin<D> basicSys<D>::pivotOrigin(const std::vector<bodyId>& pivots) const {
+    generator::origin<D> o;
+    for (auto& p : pivots) if (originalBodies.contains(p)) {
+      const body& a = originalBodies.at(p);
+      o.position = o.position + a.getPosition()*a.getMass();
+      o.velocity = o.velocity + a.getVelocity()*a.getMass();
+      o.mass += a.getMass();
     }
-    if (massSum>0){
-      centerOfMassPos = centerOfMassPos/massSum;
-      centerOfMassVel = centerOfMassVel/massSum;
+    if (o.mass>0){
+      o.position = o.position/o.mass;
+      o.velocity = o.velocity/o.mass;
+    }
+    return o;
+}
+
+template <std::size_t D>
+std::size_t basicSys<D>::generate(const generator::population& p, const std::vector<bodyId>& pivots){
+    std::vector<body> population = generator::generate<D>(p, pivotOrigin(pivots), 0, p.count);
+    originalBodies.reserve(originalBodies.size()+population.size());
+    std::size_t added = 0;
+    for (auto& b : population) if (originalBodies.insert(std::move(b)) != registry<body>::invalid) added++;
+    std::cout << "Generated " << added << " bodies";
+    if (added < population.size()) std::cout << " (" << population.size()-added << " names were taken)";
+    std::cout << "\n";
+    return added;
+}
+
+template <std::size_t D>
+typename basicSys<D>::bodyId basicSys<D>::linkBody (body b){
+  std::string name = b.getName();
+  bodyId id = originalBodies.insert(std::move(b));
+  if (id == registry<body>::invalid) std::cout << "A body named " << name << " already exists\n";
+  else std::cout << "Linked body " << name << "\n";
+  return id;
+}
+
+template <std::size_t D>
+typename basicSys<D>::bodyId basicSys<D>::linkBody(double mass, double radius, double distance, const std::vector<std::string>& pivots,
+  double angularVelocity, std::string name, double temperature, bool heatSource, double orbitalAngle, bool inverted, double dayAngle,
+  double inclination){
+    std::vector<bodyId> ids;
+    for (auto& p : pivots){
+      bodyId id = originalBodies.find(p);
+      if (id != registry<body>::invalid) ids.push_back(id);
     }
+    return linkBody(mass, radius, distance, ids, angularVelocity, name, temperature, heatSource, orbitalAngle, inverted, dayAngle, inclination);
+}
+
+template <std::size_t D>
+typename basicSys<D>::bodyId basicSys<D>::linkBody(double mass, double radius, double distance, const std::vector<bodyId>& pivots,
+  double angularVelocity, std::string name, double temperature, bool heatSource, double orbitalAngle, bool inverted, double dayAngle,
+  double inclination){
+    // Find center of mass quantities
+    generator::origin<D> o = pivotOrigin(pivots);
+    const vecD& centerOfMassPos = o.position;
+    const vecD& centerOfMassVel = o.velocity;
+    double massSum = o.mass;
 
     // Set body quantities - velocity and position
     double speed;
     if (distance == 0) speed = 0; else speed = abs(sqrt(G*massSum/distance));
-    vec2 pos = centerOfMassPos + distance*vec2(cos(orbitalAngle),sin(orbitalAngle));
-    vec2 vel = centerOfMassVel;
-    if (inverted) vel = vel - speed*vec2(-sin(orbitalAngle),cos(orbitalAngle));
-    else vel = vel + speed*vec2(-sin(orbitalAngle),cos(orbitalAngle));
+    // radial and tangential directions, tilted about the x axis by the inclination
+    vecD radial, tangent;
+    radial[0] = cos(orbitalAngle); tangent[0] = -sin(orbitalAngle);
+    radial[1] = sin(orbitalAngle); tangent[1] = cos(orbitalAngle);
+    if constexpr (D >= 3){
+      radial[2] = radial[1]*sin(inclination); radial[1] *= cos(inclination);
+      tangent[2] = tangent[1]*sin(inclination); tangent[1] *= cos(inclination);
+    }
+    vecD pos = centerOfMassPos + distance*radial;
+    vecD vel = centerOfMassVel;
+    if (inverted) vel = vel - speed*tangent;
+    else vel = vel + speed*tangent;
     // Create Body
-    originalBodies.push_back( body(mass, radius, pos, vel, vec2(), angularVelocity, name, temperature, heatSource, dayAngle) );
+    bodyId id = originalBodies.insert( body(mass, radius, pos, vel, vecD(), angularVelocity, name, temperature, heatSource, dayAngle) );
+    if (id == registry<body>::invalid){
+      std::cout << "A body named " << name << " already exists\n";
+      return id;
+    }
 
-    std::cout << "Created new body: pos(" << pos.X() << " , " << pos.Y() << "), vel(" << vel.X() << " , " << vel.Y() << ")\n";
+    std::cout << "Created new body: pos(";
+    for (std::size_t k = 0; k < D; k++) std::cout << (k ? " , " : "") << pos[k];
+    std::cout << "), vel(";
+    for (std::size_t k = 0; k < D; k++) std::cout << (k ? " , " : "") << vel[k];
+    std::cout << ")\n";
+    return id;
 }
 
-DECLARE_APP(app)
-void sys::solve(double T, double dT, frame* f){
+template <std::size_t D>
+std::size_t basicSys<D>::stepsUntil(double start, double T, double dT){
+    std::size_t n = 0;
+    if (dT > 0) for (double t = start; t < T; t += dT) n++;
+    return n;
+}
 
-    // events
-    wxCommandEvent prog( wxEVT_COMMAND_TEXT_UPDATED, PROGRESS );
-    wxCommandEvent stat( wxEVT_COMMAND_TEXT_UPDATED, STATUS );
-    int val;
-    std::string msg;
+template <std::size_t D>
+std::uintmax_t basicSys<D>::recordSize(double T, double dT) const {
+    return recording ? seriesStore::bytes(seriesCount(originalBodies.size()), stepsUntil(0, T, dT)) : 0;
+}
 
-    // clean-up
-    bodies = originalBodies;
-    distanceToBodies.clear();
-    times.clear(); temperature.clear(); orbitalSpeed.clear(); orbitalAccel.clear();
-    xPositions.clear(); yPositions.clear();
+template <std::size_t D>
+void basicSys<D>::solve(double T, double dT, progressCallback progress){
+
+    // progress is reported by rank 0 only
+    bool root = parallel::rank() == 0;
+    int val = -1;
+    auto report = [&](int percent, const std::string& msg){
+      if (progress && root) progress(percent, msg);
+    };
+
+    keyframeStep = dT;
+    // parallel in time - every slice would need every rank, so distributed runs stay serial
+    pararealResult = {};
+    if (parareal.enabled && parallel::ranks() == 1){
+      solveParareal(T, dT, progress);
+      return;
+    }
+    if (root && parareal.enabled) std::cout << "Parareal is not used when distributed\n";
+
+    // cached run - reused as is, or continued when shorter than requested
+    bool resumed = false;
+    bool cacheable = cache && parallel::ranks() == 1 && !events.enabled();
+    std::string input = cacheable ? canonicalInput(dT) : "";
+    std::uint64_t key = binary::hash(input);
+    if (cacheable && cache->load(key, [&](std::istream& in){ return readRun(in, input); })){
+      if (stopped == stopReason::none ? duration <= T : stopTime < T){
+        resumed = true;
+        if (stopped == stopReason::none && duration < T) std::cout << "|| Cached run found, continuing from t = " << clock << " s\n";
+        else std::cout << "|| Cached run found\n";
+      }else{
+        // the cached run goes further than requested, keep it
+        cacheable = false;
+      }
+    }
+
+    if (!resumed) reset();
+    long firstStep = steps;
     // SOLVING
-    std::cout << "|| Solving system ...\n";
-    // Allocate Space
-    std::cout << "Allocating space\n";
-    temperature.resize(bodies.size()); orbitalSpeed.resize(bodies.size()); orbitalAccel.resize(bodies.size());
-    xPositions.resize(bodies.size()); yPositions.resize(bodies.size());
-    distanceToBodies = std::vector<std::vector<std::vector<double>>> (bodies.size(), std::vector<std::vector<double>> (bodies.size()) ) ;
+    if (root) std::cout << "|| Solving system ...\n";
+    if (root && parallel::ranks() > 1) std::cout << "Distributing " << bodies.size() << " bodies over " << parallel::ranks() << " ranks\n";
+    if (root && parallel::ranks() > 1 && regularizationRadius > 0) std::cout << "Close pairs are not regularized when distributed\n";
+    // Allocate Space - data is extracted on rank 0 only
+    bool extract = root;
+    if (extract && !resumed){
+      std::cout << "Allocating space\n";
+      allocate(stepsUntil(0, T, dT));
+    }
+    if (extract && resumed){
+      recorded.reserve(recorded.size()+stepsUntil(clock, T, dT));
+      sample.assign(recorded.series(), 0);
+      sampleHeld = false;
+    }
+    if (!resumed) previousSpeed.assign(bodies.size(), 0);
+    if (extract) openEvents();
     // Trajectories
-    std::cout << "Calculating trajectories\n";
-    for(double t = 0; t < T; t += dT){
-
-
-        val = round(f->progress_bar->GetRange()*float(t/T));
-        prog.SetInt( val );
-        f->GetEventHandler()->AddPendingEvent(prog);
-        msg = "Calculating Trajectories... ("+std::to_string(val)+" %)";
-        stat.SetString( msg );
-        f->GetEventHandler()->AddPendingEvent(stat);
-
-        std::vector<body> newBodies (bodies.size());
-        std::vector<vec2> accels (bodies.size() , vec2());
-        vec2 vel, pos;
-        for(int i = 0; i < bodies.size(); i++){
-            for(int j = i+1; j < bodies.size(); j++){
-                vec2 dist = bodies[j].getPosition() - bodies[i].getPosition();
-                vec2 r = dist.normalized();
-                double d2 = dist*dist;
-                vec2 q = (bodies[j].getMass() / d2)*r;
-                vec2 p = (bodies[i].getMass() / d2)*r;
-                accels[i] = accels[i] + q;
-                accels[j] = accels[j] - p;
+    if (root) std::cout << "Calculating trajectories\n";
+    for(double t = clock; t < T && stopped == stopReason::none; t += dT){
 
-            }
-            // update vector quantities
-            accels[i] = G*accels[i];
-            vel = bodies[i].getVelocity() + dT*accels[i];
-            pos = bodies[i].getPosition() + dT*vel;
-            // update scalar quantities
-            double temp = 0;
-            if (bodies[i].getIsHeatSource()) temp = bodies[i].getTemperature();
-            else{
-              for (int k = 0; k < bodies.size(); k++){
-                if(k!=i){
-                  double Tk4 = pow(bodies[k].getTemperature(),4);
-                  double Rk2 = bodies[k].getRadius()*bodies[k].getRadius();
-                  vec2 D = bodies[i].getPosition()-bodies[k].getPosition();
-                  double D2 = D*D;
-                  temp += Tk4*Rk2/D2;
-                }
-              }
-              temp = pow(temp,0.25);
-              temp*=ONE_OVER_SQRT_2;
-            }
-            double updatedAngle = dT*bodies[i].getAngularVelocity(); while (updatedAngle>2*PI) updatedAngle-=2*PI; while (updatedAngle < 0) updatedAngle+= 2*PI;
-            // update body
-            newBodies[i] = body(bodies[i].getMass(),bodies[i].getRadius(),pos,vel,accels[i],bodies[i].getAngularVelocity(),bodies[i].getName(),temp,bodies[i].getIsHeatSource(),updatedAngle);
+        int percent = round(100*float(t/T));
+        if (percent != val){
+          val = percent;
+          report(val, "Calculating Trajectories... ("+std::to_string(val)+" %)");
+        }
+
+        if (!step(t, dT, extract)) break;
+    }
+    duration = stopped == stopReason::none ? T : stopTime;
+    if (extract) closeSample();
+    flushEvents();
+    eventLog.reset();
+    if (root && stopped != stopReason::none) std::cout << "Stopped at t = " << stopTime << " s: " << stopMessage << "\n";
+    // only runs that were computed or continued, an exact hit is already stored
+    if (cacheable && stopped != stopReason::cancelled && steps > firstStep) cache->store(key, [&](std::ostream& out){ writeRun(out, input); });
+
+    report(0, stopped == stopReason::none ? "Done!" : "Stopped early: "+stopMessage);
+
+    // DONE
+    if (root) std::cout << "Done!\n";
+}
+
+template <std::size_t D>
+sequence<typename basicSys<D>::stateView> basicSys<D>::run(double T, double dT, long every){
+    reset();
+    keyframeStep = dT;
+    pararealResult = {};
+    duration = 0;
+    auto view = [&]{ return stateView{clock, steps, bodies, getEnergyDrift(), getMomentumDrift()}; };
+    co_yield view();
+    // the same steps as solve, without extraction
+    for (double t = 0; t < T; t += dT){
+        bool going = step(t, dT, false);
+        bool last = !going || !(t + dT < T);
+        // the drifts of the state reached, not of the step's start
+        if (last || (every > 0 && steps % every == 0)){ measure(); co_yield view(); }
+        if (!going) break;
+    }
+    duration = stopped == stopReason::none ? T : stopTime;
+}
+
+template <std::size_t D>
+void basicSys<D>::reset(){
+    bodies.assign(originalBodies.data().begin(), originalBodies.data().end());
+    recorded.open(0, memoryBudget, spillDirectory);
+    temperatureStats.clear(); speedStats.clear(); orbitStats.clear();
+    stopped = stopReason::none; stopMessage = ""; stopTime = 0;
+    pendingEvents.clear(); eventCounts = {};
+    keyframeSteps.clear(); keyframes.clear();
+    energyDriftStats = {}; momentumDriftStats = {};
+    driftWarning = "";
+    measure();
+    initialEnergy = energy; initialMomentum = momentum;
+    // relative to the total, or to the sum of the magnitudes when the total vanishes
+    momentumScale = momentum.size();
+    if (momentumScale == 0) for (auto& b : bodies) momentumScale += b.getMass()*b.getPosition().size()*b.getVelocity().size();
+    clock = 0; steps = 0;
+}
+
+template <std::size_t D>
+void basicSys<D>::allocate(std::size_t expected){
+    recorded.open(recording ? seriesCount(bodies.size()) : 0, memoryBudget, spillDirectory);
+    recorded.reserve(expected);
+    sample.assign(recorded.series(), 0);
+    sampleHeld = false;
+    temperatureStats.resize(bodies.size()); speedStats.resize(bodies.size());
+    orbitStats = std::vector<std::vector<orbitStat>> (bodies.size(), std::vector<orbitStat> (bodies.size()) );
+}
+
+template <std::size_t D>
+void basicSys<D>::extractData(double t, double dT){
+    // statistics are streamed, series only kept when recording
+    double energyDrift = getEnergyDrift(), momentumDrift = getMomentumDrift();
+    energyDriftStats.push(energyDrift);
+    momentumDriftStats.push(momentumDrift);
+    // the drifts are of the state at the start of the step - the held sample
+    if (recording && sampleHeld){ sample[1] = energyDrift; sample[2] = momentumDrift; recorded.push(sample); }
+    if (recording){ sample[0] = t; sample[1] = sample[2] = 0; }
+    for(int i = 0; i < bodies.size(); i++){
+        double speed = bodies[i].getVelocity().size();
+        temperatureStats[i].push( bodies[i].getTemperature() );
+        speedStats[i].push( speed );
+        if (recording){
+          sample[bodySeries(i)] = bodies[i].getTemperature();
+          sample[bodySeries(i)+1] = speed;
+          sample[bodySeries(i)+2] = steps == 0 ? 0 : (speed-previousSpeed[i])/dT;
+        }
+        previousSpeed[i] = speed;
+        for(int j = i+1; j < bodies.size(); j++){
+          double d = (bodies[i].getPosition()-bodies[j].getPosition()).size();
+          orbitStats[i][j].push(t,d);
+          if (recording) sample[pairSeries(i,j)] = d;
         }
-        // Trajectory Update
-        bodies = newBodies;
-        // Data Extraction
-        times.push_back(t);
-        for(int i = 0; i < bodies.size(); i++){
-            temperature[i].push_back( bodies[i].getTemperature() );
-            orbitalSpeed[i].push_back(bodies[i].getVelocity().size());
-            for(int j = 0; j < bodies.size(); j++) if(i!=j) distanceToBodies[i][j].push_back( (bodies[i].getPosition()-bodies[j].getPosition()).size() );
+    }
+    sampleHeld = recording;
+}
+
+template <std::size_t D>
+void basicSys<D>::closeSample(){
+    // no step follows the last state, it is measured on its own
+    measure();
+    if (sampleHeld){ sample[1] = getEnergyDrift(); sample[2] = getMomentumDrift(); recorded.push(sample); }
+    sampleHeld = false;
+}
+
+template <std::size_t D>
+bool basicSys<D>::step(double t, double dT, bool extract){
+    // full state every keyframeInterval steps
+    if (extract && keyframeInterval > 0 && steps % keyframeInterval == 0){
+      keyframeSteps.push_back(steps);
+      keyframes.push_back(bodies);
+    }
+    // start of the step, kept for event detection
+    bool detect = extract && events.enabled();
+    if (detect){
+      stepPositions.resize(bodies.size()); stepVelocities.resize(bodies.size());
+      for (int i = 0; i < bodies.size(); i++){ stepPositions[i] = bodies[i].getPosition(); stepVelocities[i] = bodies[i].getVelocity(); }
+    }
+    // Trajectory Update
+    advance(dT);
+    // Data Extraction - samples are of the state at the end of the step, labelled with its time like events
+    if (extract) extractData(t + dT, dT);
+    if (detect) detectEvents(t, dT);
+    steps++;
+    clock = t + dT;
+    // Early termination, at the time of the state just reached - every rank holds the full state, so all of them
+    // stop together
+    if (cancelToken && *cancelToken){
+      stopped = stopReason::cancelled; stopMessage = "cancelled"; stopTime = clock;
+      return false;
+    }
+    return !(criteria.checkInterval > 0 && steps % criteria.checkInterval == 0 && checkStop(clock));
+}
+
+template <std::size_t D>
+std::vector<typename basicSys<D>::body> basicSys<D>::propagate(const std::vector<body>& start, long n, double dT) const {
+    // bare integration, nothing extracted or recorded
+    basicSys<D> worker;
+    worker.softening = softening;
+    worker.regularizationRadius = regularizationRadius;
+    worker.bodies = start;
+    // serial - queries and Parareal's coarse runs happen on one rank
+    for (long k = 0; k < n; k++) worker.advance(dT, false);
+    return worker.bodies;
+}
+
+template <std::size_t D>
+void basicSys<D>::findPairs(){
+    // mutually nearest neighbours closer than the regularization radius
+    int N = bodies.size();
+    std::vector<int> nearest (N, -1);
+    std::vector<double> nearest2 (N, regularizationRadius*regularizationRadius);
+    for(int i = 0; i < N; i++){
+        for(int j = i+1; j < N; j++){
+            vecD dist = bodies[j].getPosition() - bodies[i].getPosition();
+            double d2 = dist*dist;
+            if (d2 < nearest2[i]){ nearest2[i] = d2; nearest[i] = j; }
+            if (d2 < nearest2[j]){ nearest2[j] = d2; nearest[j] = i; }
         }
     }
+    partner.assign(N, -1);
+    for(int i = 0; i < N; i++) if (nearest[i] >= 0 && nearest[nearest[i]] == i) partner[i] = nearest[i];
+}
 
-    val = 0;
-    prog.SetInt( val );
-    f->GetEventHandler()->AddPendingEvent(prog);
-    msg = "Done!";
-    stat.SetString( msg );
-    f->GetEventHandler()->AddPendingEvent(stat);
+template <std::size_t D>
+void basicSys<D>::advance(double dT, bool distributed){
+    int N = bodies.size();
+    std::vector<body> newBodies (N);
+    std::vector<vecD> accels (N, vecD());
+    const double softening2 = softening*softening;
+    // conserved quantities of the current state, gathered along the way
+    double kinetic = 0, potential = 0;
+    vec3 angularMomentum;
+    if (!distributed || parallel::ranks() == 1){
+      bool regularize = regularizationRadius > 0;
+      if (regularize) findPairs();
+      // pairwise forces, each pair visited once - regularized pairs only feel outside forces here
+      for(int i = 0; i < N; i++){
+          kinetic += 0.5*bodies[i].getMass()*(bodies[i].getVelocity()*bodies[i].getVelocity());
+          angularMomentum += bodies[i].getMass()*cross(bodies[i].getPosition(), bodies[i].getVelocity());
+          for(int j = i+1; j < N; j++){
+              if (regularize && partner[i] == j) continue;
+              vecD dist = bodies[j].getPosition() - bodies[i].getPosition();
+              double d2 = dist*dist + softening2;
+              double d = sqrt(d2);
+              vecD r = softening2 > 0 ? dist/d : (1/d)*dist;
+              potential -= bodies[i].getMass()*bodies[j].getMass()/d;
+              vecD q = (bodies[j].getMass() / d2)*r;
+              vecD p = (bodies[i].getMass() / d2)*r;
+              accels[i] = accels[i] + q;
+              accels[j] = accels[j] - p;
 
+          }
+          newBodies[i] = evolve(i, G*accels[i], dT);
+      }
+      // regularized pairs - centre of mass drifts freely, relative motion follows the exact two-body orbit
+      if (regularize) for(int i = 0; i < N; i++){
+          int j = partner[i];
+          if (j < i) continue;
+          double mi = bodies[i].getMass(), mj = bodies[j].getMass(), M = mi+mj;
+          if (M <= 0) continue;
+          vecD xi = bodies[i].getPosition(), xj = bodies[j].getPosition();
+          vecD vi = newBodies[i].getVelocity(), vj = newBodies[j].getVelocity();
+          vecD X = (mi*xi + mj*xj)/M, V = (mi*vi + mj*vj)/M;
+          vecD r = xj - xi, v = vj - vi;
+          double d = r.size();
+          potential -= mi*mj/d;
+          vecD mutual = (G/(d*d*d))*r;
+          kepler::drift(r, v, G*M, dT);
+          X = X + dT*V;
+          auto place = [&](int k, const vecD& pos, const vecD& vel, const vecD& acc){
+              const body& b = newBodies[k];
+              newBodies[k] = body(b.getMass(),b.getRadius(),pos,vel,acc,b.getAngularVelocity(),b.getName(),b.getTemperature(),b.getIsHeatSource(),b.getAngle());
+          };
+          place(i, X - (mj/M)*r, V - (mj/M)*v, newBodies[i].getAcceleration() + mj*mutual);
+          place(j, X + (mi/M)*r, V + (mi/M)*v, newBodies[j].getAcceleration() - mi*mutual);
+      }
+      bodies = newBodies;
+      energy = kinetic + G*potential;
+      momentum = angularMomentum;
+      return;
+    }
+    // distributed - each rank computes the full force on its own block of bodies, then states are exchanged
+    auto [firstBody, lastBody] = parallel::block(N);
+    const std::size_t stride = 3*D+3;
+    std::vector<double> local, global;
+    local.reserve((lastBody-firstBody)*stride);
+    for(int i = firstBody; i < lastBody; i++){
+        // every pair is seen from both sides, each holding half of its potential energy
+        double pairs = 0;
+        for(int j = 0; j < N; j++){
+            if (j == i) continue;
+            vecD dist = bodies[j].getPosition() - bodies[i].getPosition();
+            double d2 = dist*dist + softening2;
+            double d = sqrt(d2);
+            accels[i] = accels[i] + (bodies[j].getMass() / d2)*(softening2 > 0 ? dist/d : (1/d)*dist);
+            pairs -= 0.5*bodies[i].getMass()*bodies[j].getMass()/d;
+        }
+        body b = evolve(i, G*accels[i], dT);
+        for (std::size_t k = 0; k < D; k++) local.push_back(b.getPosition()[k]);
+        for (std::size_t k = 0; k < D; k++) local.push_back(b.getVelocity()[k]);
+        for (std::size_t k = 0; k < D; k++) local.push_back(b.getAcceleration()[k]);
+        local.push_back(b.getTemperature());
+        local.push_back(b.getAngle());
+        local.push_back(pairs);
+    }
+    parallel::allgather(local, global, N, stride);
+    for(int i = 0; i < N; i++){
+        const double* state = global.data()+i*stride;
+        kinetic += 0.5*bodies[i].getMass()*(bodies[i].getVelocity()*bodies[i].getVelocity());
+        angularMomentum += bodies[i].getMass()*cross(bodies[i].getPosition(), bodies[i].getVelocity());
+        potential += state[3*D+2];
+        vecD pos, vel, acc;
+        for (std::size_t k = 0; k < D; k++){ pos[k] = state[k]; vel[k] = state[D+k]; acc[k] = state[2*D+k]; }
+        bodies[i] = body(bodies[i].getMass(),bodies[i].getRadius(),pos,vel,acc,bodies[i].getAngularVelocity(),bodies[i].getName(),state[3*D],bodies[i].getIsHeatSource(),state[3*D+1]);
+    }
+    energy = kinetic + G*potential;
+    momentum = angularMomentum;
+}
 
-    // Data analysis from data extraction
-    std::cout << "Extracting extra data\n";
-    int BSN = bodies.size();
-    for(int i = 0; i < BSN; i++){
+template <std::size_t D>
+typename basicSys<D>::body basicSys<D>::evolve(int i, const vecD& accel, double dT) const {
+    // update vector quantities
+    vecD vel = bodies[i].getVelocity() + dT*accel;
+    vecD pos = bodies[i].getPosition() + dT*vel;
+    // update scalar quantities
+    double temp = 0;
+    if (bodies[i].getIsHeatSource()) temp = bodies[i].getTemperature();
+    else{
+      for (int k = 0; k < bodies.size(); k++){
+        if(k!=i){
+          double Tk4 = pow(bodies[k].getTemperature(),4);
+          double Rk2 = bodies[k].getRadius()*bodies[k].getRadius();
+          vecD Dk = bodies[i].getPosition()-bodies[k].getPosition();
+          double D2 = Dk*Dk;
+          temp += Tk4*Rk2/D2;
+        }
+      }
+      temp = pow(temp,0.25);
+      temp*=ONE_OVER_SQRT_2;
+    }
+    double updatedAngle = dT*bodies[i].getAngularVelocity(); while (updatedAngle>2*PI) updatedAngle-=2*PI; while (updatedAngle < 0) updatedAngle+= 2*PI;
+    // update body
+    return body(bodies[i].getMass(),bodies[i].getRadius(),pos,vel,accel,bodies[i].getAngularVelocity(),bodies[i].getName(),temp,bodies[i].getIsHeatSource(),updatedAngle);
+}
 
-        val = round(f->progress_bar->GetRange()*float(i)/float(BSN));
-        prog.SetInt( val );
-        f->GetEventHandler()->AddPendingEvent(prog);
-        msg = "Extracting additional data... ("+std::to_string(val)+" %)";
-        stat.SetString( msg );
-        f->GetEventHandler()->AddPendingEvent(stat);
+template <std::size_t D>
+void basicSys<D>::measure(){
+    // separate pass - only for states the force loop has not seen yet, summed in the order of its serial loop so a
+    // state gets the same values either way: softened pairs first, then the pairs it regularizes
+    bool regularize = regularizationRadius > 0 && parallel::ranks() == 1;
+    if (regularize) findPairs();
+    const double softening2 = softening*softening;
+    int N = bodies.size();
+    double kinetic = 0, potential = 0;
+    vec3 angularMomentum;
+    for(int i = 0; i < N; i++){
+        kinetic += 0.5*bodies[i].getMass()*(bodies[i].getVelocity()*bodies[i].getVelocity());
+        angularMomentum += bodies[i].getMass()*cross(bodies[i].getPosition(), bodies[i].getVelocity());
+        for(int j = i+1; j < N; j++){
+            if (regularize && partner[i] == j) continue;
+            vecD dist = bodies[j].getPosition() - bodies[i].getPosition();
+            potential -= bodies[i].getMass()*bodies[j].getMass()/sqrt(dist*dist + softening2);
+        }
+    }
+    if (regularize) for(int i = 0; i < N; i++){
+        int j = partner[i];
+        if (j < i || bodies[i].getMass()+bodies[j].getMass() <= 0) continue;
+        potential -= bodies[i].getMass()*bodies[j].getMass()/(bodies[j].getPosition() - bodies[i].getPosition()).size();
+    }
+    energy = kinetic + G*potential;
+    momentum = angularMomentum;
+}
 
-        orbitalAccel[i].push_back(0);
-        for (int j = 1; j < orbitalSpeed[i].size(); j++){
-            orbitalAccel[i].push_back( (orbitalSpeed[i][j]-orbitalSpeed[i][j-1]) / dT );
+template <std::size_t D>
+bool basicSys<D>::checkStop(double t){
+    int N = bodies.size();
+    auto stop = [&](stopReason r, std::string message){
+        stopped = r; stopMessage = message; stopTime = t;
+        return true;
+    };
+    // Ejection - unbound and beyond the escape radius, relative to the centre of mass
+    if (criteria.escapeRadius > 0){
+        vecD cmPos, cmVel;
+        double massSum = 0;
+        for (auto& b : bodies){
+            cmPos = cmPos + b.getMass()*b.getPosition();
+            cmVel = cmVel + b.getMass()*b.getVelocity();
+            massSum += b.getMass();
+        }
+        if (massSum > 0){ cmPos = cmPos/massSum; cmVel = cmVel/massSum; }
+        for (auto& b : bodies){
+            double r = (b.getPosition()-cmPos).size();
+            if (r > criteria.escapeRadius){
+                double v = (b.getVelocity()-cmVel).size();
+                if (v*v > 2*G*(massSum-b.getMass())/r) return stop(stopReason::ejection, b.getName()+" was ejected");
+            }
+        }
+    }
+    // Close encounters and collisions
+    if (criteria.hillFactor > 0 || criteria.collisions){
+        // mutual Hill radii are taken around the most massive body:
+        // R_H = ((mi+mj)/(3 Mk))^(1/3) (ai+aj)/2, with ai and aj the distances to it
+        int k = 0;
+        for (int i = 1; i < N; i++) if (bodies[i].getMass() > bodies[k].getMass()) k = i;
+        std::vector<double> a (N, 0);
+        for (int i = 0; i < N; i++) a[i] = (bodies[i].getPosition()-bodies[k].getPosition()).size();
+        for (int i = 0; i < N; i++) for (int j = i+1; j < N; j++){
+            double d = (bodies[j].getPosition()-bodies[i].getPosition()).size();
+            if (criteria.collisions && d < bodies[i].getRadius()+bodies[j].getRadius())
+                return stop(stopReason::collision, bodies[i].getName()+" collided with "+bodies[j].getName());
+            if (criteria.hillFactor > 0 && i != k && j != k && bodies[k].getMass() > 0
+              && d < criteria.hillFactor*cbrt((bodies[i].getMass()+bodies[j].getMass())/(3*bodies[k].getMass()))*(a[i]+a[j])/2)
+                return stop(stopReason::closeEncounter, bodies[i].getName()+" had a close encounter with "+bodies[j].getName());
         }
     }
+    // Conservation - drift of the monitored energy and angular momentum, a warning is given once
+    auto drift = [&](double value, double tolerance, const std::string& quantity){
+        if (tolerance <= 0 || value <= tolerance) return false;
+        std::stringstream message;
+        message << quantity << " drift of " << value << " exceeded the tolerance";
+        if (!criteria.warnOnDrift) return stop(stopReason::conservation, message.str());
+        if (driftWarning == ""){
+            message << " at t = " << t << " s";
+            driftWarning = message.str();
+            std::cout << "Warning: " << driftWarning << "\n";
+        }
+        return false;
+    };
+    if (drift(getEnergyDrift(), criteria.energyDrift, "energy")) return true;
+    if (drift(getMomentumDrift(), criteria.momentumDrift, "angular momentum")) return true;
+    return false;
+}
 
-    val = 0;
-    prog.SetInt( val );
-    f->GetEventHandler()->AddPendingEvent(prog);
-    msg = "Done!";
-    stat.SetString( msg );
-    f->GetEventHandler()->AddPendingEvent(stat);
+///////////////////////////////////// FILES
+
+// binary .sys files start with this tag, followed by the dimension, the number of bodies and the bodies
+constexpr char binaryTag[8] = "SYSBIN1";
+
+template <std::size_t D>
+bool basicSys<D>::load(const std::string& path){
+    std::cout << "Loading file " << path << "\n";
+    std::ifstream input (path, std::ios::binary);
+    if (!input.is_open()) return false;
+    originalBodies.clear();
+
+    char tag[sizeof(binaryTag)] = {};
+    if (input.read(tag, sizeof(tag)) && std::equal(tag, tag+sizeof(tag), binaryTag)){
+      std::uint64_t dimension, N;
+      if (!binary::read(input, dimension) || dimension != D || !binary::read(input, N)) return false;
+      originalBodies.reserve(N);
+      body b;
+      for (std::uint64_t i = 0; i < N; i++){
+        if (!readBody(input, b)) return false;
+        std::string name = b.getName();
+        if (originalBodies.insert(std::move(b)) == registry<body>::invalid) std::cout << "A body named " << name << " already exists, skipped\n";
+      }
+      std::cout << "Loaded " << originalBodies.size() << " bodies\n";
+      return true;
+    }
+    input.clear();
+    input.seekg(0);
+
+    double M = 0, R = 0, T = 0, angulVel = 0, dayAngle = 0;
+    vecD pos, vel, acc;
+    bool heatSource = false;
+    std::string name;
+    std::string in;
+
+    while (input >> in){
+      if (in == "NAME"){
+        input >> name;
+      }else if(in == "MASS"){
+        input >> M;
+      }else if(in == "RADIUS"){
+        input >> R;
+      }else if(in == "TEMP"){
+        input >> T;
+      }else if(in == "ANGLE"){
+        input >> dayAngle;
+      }else if(in == "ANGVEL"){
+        input >> angulVel;
+      }else if(in == "POS"){
+        for (std::size_t k = 0; k < D; k++) input >> pos[k];
+      }else if(in == "VEL"){
+        for (std::size_t k = 0; k < D; k++) input >> vel[k];
+      }else if(in == "ACC"){
+        for (std::size_t k = 0; k < D; k++) input >> acc[k];
+      }else if(in == "HEATSRC"){
+        input >> heatSource;
+      }else if(in == ")"){
+        linkBody( body(M,R,pos,vel,acc,angulVel,name,T,heatSource,dayAngle) );
+      }
+    }
+    return true;
+}
 
-    // DONE
-    std::cout << "Done!\n";
+template <std::size_t D>
+bool basicSys<D>::save(const std::string& path, bool binaryFormat) const {
+    std::cout << "Saving file " << path << "\n";
+    std::ofstream output (path, binaryFormat ? std::ios::binary : std::ios::out);
+    if (!output.is_open()) return false;
+    if (binaryFormat){
+      output.write(binaryTag, sizeof(binaryTag));
+      binary::write(output, std::uint64_t(D));
+      binary::write(output, std::uint64_t(originalBodies.size()));
+      for (auto& b : originalBodies.data()) writeBody(output, b);
+      return bool(output);
+    }
+    output.precision(17);
+    for (auto& b : originalBodies.data()){
+      output << "( NAME " << b.getName() << " MASS " << b.getMass()
+      << " RADIUS " << b.getRadius() << " TEMP " << b.getTemperature()
+      << " ANGLE " << b.getAngle() << " ANGVEL " << b.getAngularVelocity() << " POS";
+      for (std::size_t k = 0; k < D; k++) output << " " << b.getPosition()[k];
+      output << " VEL";
+      for (std::size_t k = 0; k < D; k++) output << " " << b.getVelocity()[k];
+      output << " ACC";
+      for (std::size_t k = 0; k < D; k++) output << " " << b.getAcceleration()[k];
+      output << " HEATSRC " << b.getIsHeatSource() << " )"
+      << "\n";
+    }
+    return true;
+}
+
+template <std::size_t D>
+bool basicSys<D>::generateFile(const generator::population& p, const std::string& path, const std::vector<bodyId>& pivots) const {
+    std::cout << "Generating " << p.count << " bodies into " << path << "\n";
+    std::ofstream output (path, std::ios::binary);
+    if (!output.is_open()) return false;
+    output.write(binaryTag, sizeof(binaryTag));
+    binary::write(output, std::uint64_t(D));
+    // the count is patched once the bodies with taken names have been skipped
+    std::streampos countPosition = output.tellp();
+    std::uint64_t count = originalBodies.size();
+    binary::write(output, count);
+    for (auto& b : originalBodies.data()) writeBody(output, b);
+    // one chunk in memory at a time
+    generator::origin<D> o = pivotOrigin(pivots);
+    const std::size_t chunk = 1 << 16;
+    for (std::size_t first = 0; first < p.count; first += chunk)
+      for (auto& b : generator::generate<D>(p, o, first, first+chunk)){
+        if (originalBodies.find(b.getName()) != registry<body>::invalid) continue;
+        writeBody(output, b);
+        count++;
+      }
+    if (count < originalBodies.size()+p.count) std::cout << originalBodies.size()+p.count-count << " names were taken\n";
+    output.seekp(countPosition);
+    binary::write(output, count);
+    return bool(output);
+}
+
+///////////////////////////////////// KEYFRAMES
+
+// keyframe files start with this tag, followed by the solver parameters, the end of the run (duration and step
+// count), the number of keyframes and the keyframes
+constexpr char keyframeTag[8] = "KEYFRM2";
+
+template <std::size_t D>
+std::vector<typename basicSys<D>::body> basicSys<D>::stateAt(double t) const {
+    if (keyframes.empty() || keyframeStep <= 0) return {};
+    // only times of the run - its end is the state after the last step, whatever the remainder of T/dT
+    if (t < 0 || t > duration) return {};
+    // the step nearest to t, integrated from the last keyframe before it
+    long n = t == duration ? steps : std::min(steps, std::lround(t/keyframeStep));
+    auto next = std::upper_bound(keyframeSteps.begin(), keyframeSteps.end(), n);
+    std::size_t k = next == keyframeSteps.begin() ? 0 : next-keyframeSteps.begin()-1;
+    return propagate(keyframes[k], std::max(0L, n-keyframeSteps[k]), keyframeStep);
 }
 
-void sys::saveData(frame* f, std::string append, std::string time_units, std::string distance_units, double time_convert, double distance_convert){
+template <std::size_t D>
+bool basicSys<D>::readKeyframes(std::istream& in, std::size_t count, std::size_t N){
+    keyframes.assign(count, std::vector<body>(N));
+    for (auto& frame : keyframes) for (auto& b : frame) if (!readBody(in, b)) return false;
+    return true;
+}
+
+template <std::size_t D>
+bool basicSys<D>::saveKeyframes(const std::string& path) const {
+    std::cout << "Saving " << keyframes.size() << " keyframes to " << path << "\n";
+    std::ofstream output (path, std::ios::binary);
+    if (!output.is_open()) return false;
+    output.write(keyframeTag, sizeof(keyframeTag));
+    binary::write(output, std::uint64_t(D));
+    binary::write(output, keyframeStep); binary::write(output, keyframeInterval);
+    // distributed runs are not regularized, queries replay them serially
+    binary::write(output, softening); binary::write(output, parallel::ranks() > 1 ? 0. : regularizationRadius);
+    binary::write(output, duration); binary::write(output, steps);
+    binary::write(output, std::uint64_t(keyframes.empty() ? 0 : keyframes.front().size()));
+    binary::write(output, keyframeSteps);
+    for (auto& frame : keyframes) for (auto& b : frame) writeBody(output, b);
+    return bool(output);
+}
+
+template <std::size_t D>
+bool basicSys<D>::loadKeyframes(const std::string& path){
+    std::cout << "Loading keyframes " << path << "\n";
+    std::ifstream input (path, std::ios::binary);
+    char tag[sizeof(keyframeTag)] = {};
+    if (!input.read(tag, sizeof(tag)) || !std::equal(tag, tag+sizeof(tag), keyframeTag)) return false;
+    std::uint64_t dimension, N;
+    if (!(binary::read(input, dimension) && dimension == D
+      && binary::read(input, keyframeStep) && binary::read(input, keyframeInterval)
+      && binary::read(input, softening) && binary::read(input, regularizationRadius)
+      && binary::read(input, duration) && binary::read(input, steps)
+      && binary::read(input, N) && binary::read(input, keyframeSteps)
+      && readKeyframes(input, keyframeSteps.size(), N))) return false;
+    // the system starts from the first keyframe
+    originalBodies.clear();
+    if (!keyframes.empty()) for (auto& b : keyframes.front()) originalBodies.insert(b);
+    return true;
+}
+
+///////////////////////////////////// CACHE
+
+// layout of the run files, part of the key so that entries written by older builds are never read
+constexpr std::uint64_t runFormat = 7;
+
+template <std::size_t D>
+std::uint64_t basicSys<D>::cacheKey(double dT) const {
+    return binary::hash(canonicalInput(dT));
+}
+
+template <std::size_t D>
+std::string basicSys<D>::canonicalInput(double dT) const {
+    // canonical initial state and solver parameters
+    std::stringstream canonical;
+    binary::write(canonical, runFormat);
+    binary::write(canonical, std::uint64_t(D));
+    binary::write(canonical, dT);
+    binary::write(canonical, recording);
+    binary::write(canonical, criteria.escapeRadius); binary::write(canonical, criteria.hillFactor);
+    binary::write(canonical, criteria.energyDrift); binary::write(canonical, criteria.collisions);
+    binary::write(canonical, criteria.momentumDrift); binary::write(canonical, criteria.warnOnDrift);
+    binary::write(canonical, criteria.checkInterval);
+    binary::write(canonical, softening); binary::write(canonical, regularizationRadius);
+    binary::write(canonical, keyframeInterval);
+    binary::write(canonical, std::uint64_t(originalBodies.size()));
+    for (auto& b : originalBodies.data()) writeBody(canonical, b);
+    return canonical.str();
+}
+
+template <std::size_t D>
+void basicSys<D>::writeRun(std::ostream& out, const std::string& input) const {
+    // the full input the run was keyed by, so that a hash collision is a miss and not another run's results
+    binary::write(out, input);
+    binary::write(out, std::uint64_t(D));
+    binary::write(out, std::uint64_t(bodies.size()));
+    for (auto& b : bodies) writeBody(out, b);
+    binary::write(out, duration); binary::write(out, clock); binary::write(out, steps);
+    binary::write(out, energy); binary::write(out, initialEnergy);
+    binary::write(out, momentum); binary::write(out, initialMomentum); binary::write(out, momentumScale);
+    binary::write(out, energyDriftStats); binary::write(out, momentumDriftStats);
+    binary::write(out, driftWarning);
+    binary::write(out, keyframeStep); binary::write(out, keyframeSteps);
+    for (auto& frame : keyframes) for (auto& b : frame) writeBody(out, b);
+    binary::write(out, stopped); binary::write(out, stopMessage); binary::write(out, stopTime);
+    binary::write(out, previousSpeed);
+    recorded.write(out);
+    binary::write(out, temperatureStats); binary::write(out, speedStats); binary::write(out, orbitStats);
+}
+
+template <std::size_t D>
+bool basicSys<D>::readRun(std::istream& in, const std::string& input){
+    std::string stored;
+    if (!binary::read(in, stored) || stored != input) return false;
+    std::uint64_t dimension, N;
+    if (!binary::read(in, dimension) || dimension != D) return false;
+    if (!binary::read(in, N) || N != originalBodies.size()) return false;
+    bodies.resize(N);
+    for (auto& b : bodies) if (!readBody(in, b)) return false;
+    // recorded series are read within the budget of this system
+    recorded.open(0, memoryBudget, spillDirectory);
+    return binary::read(in, duration) && binary::read(in, clock) && binary::read(in, steps)
+      && binary::read(in, energy) && binary::read(in, initialEnergy)
+      && binary::read(in, momentum) && binary::read(in, initialMomentum) && binary::read(in, momentumScale)
+      && binary::read(in, energyDriftStats) && binary::read(in, momentumDriftStats)
+      && binary::read(in, driftWarning)
+      && binary::read(in, keyframeStep) && binary::read(in, keyframeSteps) && readKeyframes(in, keyframeSteps.size(), N)
+      && binary::read(in, stopped) && binary::read(in, stopMessage) && binary::read(in, stopTime)
+      && binary::read(in, previousSpeed)
+      && recorded.read(in)
+      && binary::read(in, temperatureStats) && binary::read(in, speedStats) && binary::read(in, orbitStats);
+}
+
+///////////////////////////////////// ANALYSIS
+
+template <std::size_t D>
+std::string basicSys<D>::report(){
+    std::stringstream out;
+    out << "|| Run summary - " << duration << " s simulated\n";
+    if (stopped != stopReason::none) out << "Stopped early at t = " << stopTime << " s: " << stopMessage << "\n";
+    const pararealStats& p = pararealResult;
+    if (p.slices > 0){
+        out << "Parareal: " << p.slices << " slices, " << p.iterations << " iterations, "
+          << (p.converged ? "converged" : "not converged");
+        if (!p.corrections.empty()) out << " (last correction " << p.corrections.back() << ")";
+        out << ", " << p.wallTime << " s";
+        if (p.referenceTime > 0) out << "; serial " << p.referenceTime << " s, speedup " << p.referenceTime/p.wallTime
+          << ", final deviation " << p.deviation << " m";
+        out << "\n";
+    }
+    // no maximum before the first step
+    auto maximum = [](const runningStat& s){ std::stringstream m; if (s.getCount() > 0) m << s.getMax(); else m << "n/a"; return m.str(); };
+    out << "Conservation: energy drift max " << maximum(energyDriftStats) << " final " << getEnergyDrift()
+      << ", angular momentum drift max " << maximum(momentumDriftStats) << " final " << getMomentumDrift() << "\n";
+    if (driftWarning != "") out << "Warning: " << driftWarning << "\n";
+    if (recorded.isSpilled()) out << "Recorded series: " << recorded.size() << " samples, " << recorded.memoryUsage()/1048576.
+      << " MB in memory and " << recorded.diskUsage()/1048576. << " MB compressed on disk\n";
+    if (events.enabled()){
+        out << "Events:";
+        for (int k = 0; k < eventTypes; k++) out << " " << eventCounts[k] << " " << toString(eventType(k)) << (k+1 < eventTypes ? "," : "");
+        out << " (log " << events.path << ")\n";
+    }
+    for(int i = 0; i < temperatureStats.size(); i++){
+        out << "\n" << bodies[i].getName() << "\n";
+        out << "  Temperature [K]: min " << temperatureStats[i].getMin() << " mean " << temperatureStats[i].getMean()
+          << " max " << temperatureStats[i].getMax() << " range " << temperatureStats[i].getRange() << "\n";
+        out << "  Orbital speed [ms^-1]: min " << speedStats[i].getMin() << " mean " << speedStats[i].getMean()
+          << " max " << speedStats[i].getMax() << "\n";
+        for(int j = 0; j < temperatureStats.size(); j++){
+          if (i!=j){
+            const orbitStat& o = getOrbitStats(i,j);
+            out << "  Relative to " << bodies[j].getName() << ": distance [m] min " << o.getDistance().getMin()
+              << " mean " << o.getDistance().getMean() << " max " << o.getDistance().getMax()
+              << ", periapsis " << o.getPeriapsis() << " apoapsis " << o.getApoapsis()
+              << ", period [s] " << o.getPeriod() << " (" << o.getOrbits() << " orbits)"
+              << ", eccentricity " << o.getEccentricity() << "\n";
+          }
+        }
+    }
+    return out.str();
+}
+
+template <std::size_t D>
+void basicSys<D>::saveReport(std::string path){
+    std::cout << "|| Saving run summary to " << path << "\n";
+    std::ofstream output (path);
+    output << report();
+}
+
+template <std::size_t D>
+void basicSys<D>::saveData(progressCallback progress, std::string append, std::string time_units, std::string distance_units, double time_convert, double distance_convert){
 
-    // events
-    wxCommandEvent prog( wxEVT_COMMAND_TEXT_UPDATED, PROGRESS );
-    wxCommandEvent stat( wxEVT_COMMAND_TEXT_UPDATED, STATUS );
+    // only rank 0 holds the recorded series
+    if (parallel::rank() != 0 || recorded.series() == 0) return;
+    auto report = [&](int percent, const std::string& msg){
+      if (progress) progress(percent, msg);
+    };
     int val;
-    std::string msg;
 
     // SAVING
     std::cout << "|| Saving graph data ...\n";
-    // Initialize canvas and grid style
-    TCanvas canvas ("","",1080,480);
-    gStyle->SetGridStyle(0);
-    gStyle->SetGridColor(17);
-    // Converted time std::vector
-    std::vector<double> T, D;
-    for (const auto& i: times) T.push_back(i/time_convert);
+    outputBackend* output = loadOutputBackend();
+    if (!output){
+      report(0, "Could not save graphs: no output plugin");
+      return;
+    }
+    // Converted time std::vector - every other series is read back (from disk when spilled) as it is plotted
+    std::vector<double> T = recorded.get(0);
+    for (auto& elem: T) elem/=time_convert;
+    std::string timeLabel = "time ["+time_units+"]";
 
     std::string folder = "Data";
     std::filesystem::create_directory(folder);
@@ -192,67 +892,37 @@ void sys::saveData(frame* f, std::string append, std::string time_units, std::st
     for(int i = 0; i < bodies.size(); i++){
 
         float ratio = (float(i)+1)/float(bodies.size());
-        val = f->progress_bar->GetRange()*ratio;
-        prog.SetInt( val );
-        f->GetEventHandler()->AddPendingEvent(prog);
-        msg = "Saving data on "+bodies[i].getName()+" ("+std::to_string(val)+" %)";
-        stat.SetString( msg );
-        f->GetEventHandler()->AddPendingEvent(stat);
+        val = 100*ratio;
+        report(val, "Saving data on "+bodies[i].getName()+" ("+std::to_string(val)+" %)");
 
         std::cout << "Saving " << bodies[i].getName() << "\n";
 
         std::filesystem::create_directory(folder+"/"+bodies[i].getName());
+        std::string prefix = folder+"/"+bodies[i].getName()+"/"+bodies[i].getName()+append;
 
-        TGraph ET(T.size(),T.data(),temperature[i].data());
-        ET.SetLineColor(98);
-        ET.SetTitle(("Effective Temperature;time ["+time_units+"];Temperature [K]").c_str());
-        ET.Draw("AL"); gPad->SetGrid();
-        canvas.Modified();
-        canvas.Update();
-        canvas.SaveAs((folder+"/"+bodies[i].getName()+"/"+bodies[i].getName()+append+" Temperature.pdf").c_str(),"pdf");
-        canvas.Clear();
-
-        TGraph V(T.size(),T.data(),orbitalSpeed[i].data());
-        V.SetLineColor(66);
-        V.SetTitle(("Orbital Speed;time ["+time_units+"];velocity [ms^-1]").c_str());
-        V.Draw("AL"); gPad->SetGrid();
-        canvas.Modified();
-        canvas.Update();
-        canvas.SaveAs((folder+"/"+bodies[i].getName()+"/"+bodies[i].getName()+append+" Orbital Speed.pdf").c_str(),"pdf");
-        canvas.Clear();
-
-        TGraph A(T.size(),T.data(),orbitalAccel[i].data());
-        A.SetLineColor(59);
-        A.SetTitle(("Orbital Acceleration;time ["+time_units+"];acceleration [ms^-2]").c_str());
-        A.Draw("AL"); gPad->SetGrid();
-        canvas.Modified();
-        canvas.Update();
-        canvas.SaveAs((folder+"/"+bodies[i].getName()+"/"+bodies[i].getName()+append+" Orbital Acceleration.pdf").c_str(),"pdf");
-        canvas.Clear();
+        output->plot(prefix+" Temperature.pdf", "Effective Temperature", timeLabel, "Temperature [K]", T, recorded.get(bodySeries(i)), 98);
+        output->plot(prefix+" Orbital Speed.pdf", "Orbital Speed", timeLabel, "velocity [ms^-1]", T, recorded.get(bodySeries(i)+1), 66);
+        output->plot(prefix+" Orbital Acceleration.pdf", "Orbital Acceleration", timeLabel, "acceleration [ms^-2]", T, recorded.get(bodySeries(i)+2), 59);
 
         for (int j = 0; j < bodies.size(); j++){
           if(i!=j){
-            std::vector<double> v = distanceToBodies[i][j]; for (auto& elem: v) elem*=distance_convert;
-            TGraph D(T.size(),T.data(),v.data());
-            D.SetLineColor(59);
-            D.SetTitle(("Distance to "+bodies[j].getName()+";time ["+time_units+"];distance ["+distance_units+"]").c_str());
-            D.Draw("AL"); gPad->SetGrid();
-            canvas.Modified();
-            canvas.Update();
-            canvas.SaveAs((folder+"/"+bodies[i].getName()+"/"+bodies[i].getName()+append+" distance to "+bodies[j].getName()+".pdf").c_str(),"pdf");
-            canvas.Clear();
+            std::vector<double> v = recorded.get(pairSeries(std::min(i,j), std::max(i,j))); for (auto& elem: v) elem*=distance_convert;
+            output->plot(prefix+" distance to "+bodies[j].getName()+".pdf", "Distance to "+bodies[j].getName(), timeLabel, "distance ["+distance_units+"]", T, v, 59);
           }
         }
 
     }
 
-    val = 0;
-    prog.SetInt( val );
-    f->GetEventHandler()->AddPendingEvent(prog);
-    msg = "Done!";
-    stat.SetString( msg );
-    f->GetEventHandler()->AddPendingEvent(stat);
+    // conservation monitor
+    output->plot(folder+"/Energy Drift"+append+".pdf", "Relative Energy Drift", timeLabel, "|dE/E0|", T, recorded.get(1), 98);
+    output->plot(folder+"/Angular Momentum Drift"+append+".pdf", "Relative Angular Momentum Drift", timeLabel, "|dL|/|L0|", T, recorded.get(2), 66);
+
+    report(0, "Done!");
 
     // DONE
     std::cout << "Done!\n";
 }
+
+// Planar and inclined systems
+template class basicSys<2>;
+template class basicSys<3>;